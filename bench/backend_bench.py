@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""epoll vs io_uring comparison (make bench-backends).
+
+Starts the server once per event_backend, runs the same functional checks
+against each, then drives keep-alive load from several client processes and
+reports requests/s plus per-request counts taken from /proc for the server:
+read/write-class syscalls (syscr/syscw in /proc/<pid>/io) and context switches.
+syscr/syscw only count read()/readv() and write()/writev(): syscw is the log on
+both backends, and sendmsg()/sendfile()/accept4() are not counted at all.
+Exits non-zero if a functional check fails on either backend.
+
+usage: backend_bench.py [./webserv] [--duration SECONDS] [--connections N] [--port PORT]
+"""
+import argparse
+import multiprocessing
+import os
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+CONFIG = """\
+event_backend {backend};
+keepalive_requests 1000000;
+server {{
+    listen 127.0.0.1:{port};
+    root ./www/html;
+    index index.html;
+    error_page 404 /error_pages/404.html;
+}}
+"""
+
+
+def read_response(sock, buffered=b""):
+    """One HTTP response (Content-Length framed); returns (status, headers, body, leftover)."""
+    data = buffered
+    while b"\r\n\r\n" not in data:
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise ConnectionError("connection closed mid-head")
+        data += chunk
+    head, _, rest = data.partition(b"\r\n\r\n")
+    lines = head.split(b"\r\n")
+    status = int(lines[0].split()[1])
+    headers = {}
+    for line in lines[1:]:
+        name, _, value = line.partition(b":")
+        headers[name.strip().lower().decode()] = value.strip().decode()
+    length = int(headers.get("content-length", "0"))
+    if status == 304:
+        length = 0
+    while len(rest) < length:
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise ConnectionError("connection closed mid-body")
+        rest += chunk
+    return status, headers, rest[:length], rest[length:]
+
+
+def request(port, raw):
+    sock = socket.create_connection(("127.0.0.1", port))
+    sock.settimeout(5)
+    try:
+        sock.sendall(raw)
+        return read_response(sock)[:3]
+    finally:
+        sock.close()
+
+
+def functional_checks(port):
+    """Same checks for every backend; returns a list of failure messages."""
+    failures = []
+    index = open("www/html/index.html", "rb").read()
+
+    def check(name, condition):
+        if not condition:
+            failures.append(name)
+
+    status, headers, body = request(port, b"GET / HTTP/1.1\r\nHost: x\r\n\r\n")
+    check("GET / is 200 with index.html", status == 200 and body == index)
+    etag = headers.get("etag", "")
+
+    status, _, _ = request(port, b"GET /nope HTTP/1.1\r\nHost: x\r\n\r\n")
+    check("missing file is 404", status == 404)
+    status, _, _ = request(port, b"DELETE / HTTP/1.1\r\nHost: x\r\n\r\n")
+    check("DELETE is 405", status == 405)
+    status, _, _ = request(port, b"GET / HTTP/1.1\r\nHost: x\r\nContent-Length: x\r\n\r\n")
+    check("bad Content-Length is 400", status == 400)
+    status, _, body = request(port, b"GET / HTTP/1.1\r\nHost: x\r\nRange: bytes=0-9\r\n\r\n")
+    check("Range is 206 with 10 bytes", status == 206 and body == index[:10])
+    if etag:
+        status, _, _ = request(port, ("GET / HTTP/1.1\r\nHost: x\r\nIf-None-Match: %s\r\n\r\n" % etag).encode())
+        check("If-None-Match is 304", status == 304)
+
+    # Keep-alive and pipelining: 20 requests in one write, answered in order on one connection
+    sock = socket.create_connection(("127.0.0.1", port))
+    sock.settimeout(5)
+    sock.sendall(b"GET / HTTP/1.1\r\nHost: x\r\n\r\nGET /nope HTTP/1.1\r\nHost: x\r\n\r\n" * 10)
+    statuses = []
+    leftover = b""
+    try:
+        for _ in range(20):
+            status, _, _, leftover = read_response(sock, leftover)
+            statuses.append(status)
+    except (ConnectionError, socket.timeout):
+        pass
+    sock.close()
+    check("20 pipelined requests answered in order", statuses == [200, 404] * 10)
+
+    # Request split over several writes
+    sock = socket.create_connection(("127.0.0.1", port))
+    sock.settimeout(5)
+    for piece in (b"GET / HT", b"TP/1.1\r\nHo", b"st: x\r\n", b"\r\n"):
+        sock.sendall(piece)
+        time.sleep(0.05)
+    status, _, body, _ = read_response(sock)
+    sock.close()
+    check("request split over four writes", status == 200 and body == index)
+    return failures
+
+
+def load_worker(port, connections, duration, results):
+    """Keep-alive clients, one request in flight per connection."""
+    raw = b"GET / HTTP/1.1\r\nHost: x\r\n\r\n"
+    socks = []
+    for _ in range(connections):
+        sock = socket.create_connection(("127.0.0.1", port))
+        sock.settimeout(5)
+        socks.append(sock)
+    done = 0
+    deadline = time.time() + duration
+    while time.time() < deadline:
+        for sock in socks:
+            sock.sendall(raw)
+        for sock in socks:
+            read_response(sock)
+            done += 1
+    for sock in socks:
+        sock.close()
+    results.put(done)
+
+
+def server_counters(pid):
+    counters = {}
+    with open("/proc/%d/io" % pid) as io:
+        for line in io:
+            name, _, value = line.partition(":")
+            counters[name] = int(value)
+    with open("/proc/%d/status" % pid) as status:
+        for line in status:
+            name, _, value = line.partition(":")
+            if name.endswith("ctxt_switches"):
+                counters[name] = int(value)
+    return counters
+
+
+def run_backend(binary, backend, args):
+    with tempfile.NamedTemporaryFile("w", suffix=".conf", delete=False) as conf:
+        conf.write(CONFIG.format(backend=backend, port=args.port))
+    log = tempfile.TemporaryFile()
+    server = subprocess.Popen([binary, conf.name], stdout=log, stderr=subprocess.STDOUT)
+    try:
+        for _ in range(50):
+            try:
+                socket.create_connection(("127.0.0.1", args.port)).close()
+                break
+            except OSError:
+                time.sleep(0.1)
+        log.seek(0)
+        used = re.search(rb"Event backend: (\S+)", log.read())
+        used = used.group(1).decode() if used else "unknown"
+        if used != backend:
+            print("%-9s skipped: server runs %s (backend unavailable here)" % (backend, used))
+            return True
+
+        failures = functional_checks(args.port)
+        for failure in failures:
+            print("%-9s FAIL: %s" % (backend, failure))
+
+        processes = min(args.connections, os.cpu_count() or 1)
+        results = multiprocessing.Queue()
+        before = server_counters(server.pid)
+        workers = [multiprocessing.Process(target=load_worker,
+                                           args=(args.port, args.connections // processes, args.duration, results))
+                   for _ in range(processes)]
+        start = time.time()
+        for worker in workers:
+            worker.start()
+        total = sum(results.get() for _ in workers)
+        for worker in workers:
+            worker.join()
+        elapsed = time.time() - start
+        after = server_counters(server.pid)
+        delta = dict((name, after[name] - before[name]) for name in after)
+        print("%-9s %10.0f req/s  %6.2f syscr/req  %6.2f syscw/req  %6.3f ctxsw/req  functional: %s"
+              % (backend, total / elapsed, delta["syscr"] / float(total), delta["syscw"] / float(total),
+                 (delta["voluntary_ctxt_switches"] + delta["nonvoluntary_ctxt_switches"]) / float(total),
+                 "FAIL" if failures else "ok"))
+        return not failures
+    finally:
+        server.terminate()
+        server.wait()
+        log.close()
+        os.unlink(conf.name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare the epoll and io_uring event backends")
+    parser.add_argument("binary", nargs="?", default="./webserv")
+    parser.add_argument("--duration", type=float, default=5.0)
+    parser.add_argument("--connections", type=int, default=32)
+    parser.add_argument("--port", type=int, default=18080)
+    args = parser.parse_args()
+    binary = os.path.abspath(args.binary)
+    os.chdir(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))  # Configs use ./www/html
+
+    print("%d connections, %.0f s per backend" % (args.connections, args.duration))
+    ok = True
+    for backend in ("epoll", "io_uring"):
+        ok = run_backend(binary, backend, args) and ok
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,17 @@
+#ifndef BODYCONSUMER_HPP
+#define BODYCONSUMER_HPP
+
+#include <cstddef> // For size_t
+
+// Destination for a request body while it streams in (upload file, CGI stdin, ...).
+// Request::parse hands over each decoded span as soon as it is available; the
+// bytes are then dropped from the connection buffer. Without a consumer the
+// decoded body stays in the connection buffer (see Request::getBody).
+class BodyConsumer {
+public:
+    virtual ~BodyConsumer() {}
+    // Called in body order; returning false aborts the request with 500
+    virtual bool consume(const char* data, size_t length) = 0;
+};
+
+#endif // BODYCONSUMER_HPP
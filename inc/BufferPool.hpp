@@ -0,0 +1,48 @@
+#ifndef BUFFERPOOL_HPP
+#define BUFFERPOOL_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef> // For size_t
+
+#define IO_BUFFER_SIZE 16384           // Capacity of a pooled connection input buffer
+#define IO_OVERFLOW_SIZE 65536         // Shared second readv() target for large bodies
+#define IO_BUFFER_POOL_MAX_FREE 64     // Free buffers kept for reuse; the rest go back to malloc
+
+// Per event loop pool of fixed-size input buffers. A connection takes one when
+// it has something to read and gives it back as soon as it is idle again, so
+// idle keep-alive connections hold no buffer at all and busy ones reuse the
+// same few allocations. Not thread-safe: one pool per Server.
+class BufferPool {
+public:
+    BufferPool();
+
+    // Give buffer (empty) the storage of a pooled IO_BUFFER_SIZE buffer
+    void acquire(std::string& buffer);
+    // Take buffer's storage back; buffer is left empty without storage.
+    // Buffers that grew past IO_BUFFER_SIZE (long pipelines) are freed instead.
+    void release(std::string& buffer);
+
+    // Scratch space readv() fills once the connection buffer is full; the bytes
+    // are appended to that buffer right after the read
+    char* overflow();
+    size_t overflowSize() const;
+
+    // Occupancy
+    size_t getInUse() const;       // Buffers currently held by connections
+    size_t getFree() const;        // Buffers waiting in the pool
+    size_t getPeakInUse() const;
+    unsigned long getAllocations() const; // Buffers ever allocated (the rest were reuses)
+
+private:
+    std::vector<std::string> _free;
+    std::vector<char> _overflow;
+    size_t _inUse;
+    size_t _peakInUse;
+    unsigned long _allocations;
+
+    BufferPool(const BufferPool&);
+    BufferPool& operator=(const BufferPool&);
+};
+
+#endif // BUFFERPOOL_HPP
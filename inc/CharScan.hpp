@@ -0,0 +1,30 @@
+#ifndef CHARSCAN_HPP
+#define CHARSCAN_HPP
+
+#include <cstddef> // For size_t
+
+// Delimiter/character-class scanning used by Request::parse.
+// Each function returns a pointer to the first byte in [p, end) that does NOT
+// belong to the scanned class (or end). On x86 the implementation is picked once
+// at startup: AVX2 (32 bytes per step), SSE4.2 (16 bytes per step) or scalar.
+class CharScan {
+public:
+    // First '\n'
+    static const char* findLineEnd(const char* p, const char* end);
+    // First byte that isn't an RFC 9110 tchar (method, header name)
+    static const char* skipTokenChars(const char* p, const char* end);
+    // First control character other than HTAB (field values; obs-text is allowed)
+    static const char* skipFieldValueChars(const char* p, const char* end);
+    // First space or control character (request-target)
+    static const char* skipTargetChars(const char* p, const char* end);
+
+    static bool isTokenChar(unsigned char c);
+    static const char* implementation(); // "avx2", "sse4.2" or "scalar"
+    // Switch to the named implementation (make bench); false if this CPU can't run it
+    static bool select(const char* name);
+
+private:
+    CharScan();
+};
+
+#endif // CHARSCAN_HPP
@@ -3,25 +3,64 @@
 
 #include <string>
 #include <vector>
+#include <deque>
 #include <sys/socket.h> // For socket types if needed later
+#include <sys/uio.h>    // For struct iovec
 #include <netinet/in.h> // For sockaddr_in
 #include "Request.hpp"
 #include "Response.hpp"
+#include "RequestBody.hpp"
+#include "BufferPool.hpp"
+#include "EventHandler.hpp"
+#include "TimerWheel.hpp"
 #include <utility> // For std::move if needed in header later
 
-#define READ_BUFFER_SIZE 4096 // <-- Define it here
+#define MAX_PIPELINED_RESPONSES 32 // Stop parsing pipelined requests while this many responses are queued
+#define MAX_IOV_SEGMENTS 64 // Queued responses gathered into one sendmsg() call
+#define FILE_READ_CHUNK 65536 // File bytes per read when the poller sends (no sendfile through io_uring)
+
+// One piece of queued output: serialized bytes, a slice of a cached response
+// shared with the ResponseCache (sent by reference, never copied), or a range of
+// an open file that goes out with sendfile() and never passes through user space
+struct OutputSegment {
+    std::string data;
+    std::shared_ptr<const std::string> blob;
+    size_t blobOffset;
+    size_t blobLength;
+    std::shared_ptr<OpenFile> file;
+    off_t fileOffset;      // Next file byte to send
+    size_t fileRemaining;
+    bool endsResponse;     // Last segment of a response (for the pipelining cap)
+
+    OutputSegment() : blobOffset(0), blobLength(0), fileOffset(0), fileRemaining(0), endsResponse(false) {}
+
+    // In-memory bytes of the segment (data or the blob slice)
+    const char* bytes() const { return blob ? blob->data() + blobOffset : data.data(); }
+    size_t length() const { return blob ? blobLength : data.length(); }
+};
 
 enum ClientState {
-    AWAITING_REQUEST, // Waiting for/receiving request data
+    AWAITING_REQUEST, // Waiting for/receiving request data (nothing queued to send)
     REQUEST_RECEIVED, // Full request received, ready for processing
     GENERATING_RESPONSE, // Processing request, creating response
-    SENDING_RESPONSE,  // Sending response data
-    RESPONSE_SENT      // Full response sent (ready for keep-alive or close)
+    SENDING_RESPONSE,  // Responses queued (more pipelined requests may still be read meanwhile)
+    RESPONSE_SENT      // Last response sent on a non-keep-alive connection: close it
 };
 
 
-class Client {
+// Which timeout the client's timer currently enforces
+enum ClientTimeout {
+    TIMEOUT_NONE,
+    TIMEOUT_HEADER,    // Request head not complete yet (client_header_timeout, not extended by reads)
+    TIMEOUT_BODY,      // Waiting for more body bytes (client_body_timeout, re-armed on each read)
+    TIMEOUT_KEEPALIVE, // Idle between requests (keepalive_timeout)
+    TIMEOUT_SEND       // Waiting for the socket to accept more data (send_timeout, re-armed on each write)
+};
+
+// A Client is its own epoll handler: epoll_event.data.ptr points at the slab slot.
+class Client : public EventHandler {
 public:
+    Client(); // Empty slab slot (fd = -1)
     Client(int fd, const struct sockaddr_in& addr);
     ~Client();
 
@@ -39,16 +78,60 @@ public:
     void setState(ClientState newState);
 
     // Request Handling
-    ssize_t receiveData(); // Reads data into _requestBuffer
-    bool isRequestReady() const; // Checks if full request headers are received
-    Request& getRequest(); // Parses if needed, returns Request object
+    ssize_t receiveData(BufferPool& pool); // Reads data into _requestBuffer (taking a pooled buffer if needed)
+    void returnBuffers(BufferPool& pool);  // Give the input buffer back (idle or closing); its contents are dropped
+    bool isRequestReady(); // Advances the parser; true once the request is complete (or rejected)
+    bool hasCompleteHeaders() const; // Parser got past the request head
+    Request& getRequest(); // Returns the Request parsed from _requestBuffer
     const std::string& getRawRequest() const; // Get the raw buffer content
-    bool isParsed() const; // <-- Add getter for _requestParsed
+    bool isParsed() const; // Parser finished, successfully or not
+    bool isRequestValid() const; // False if Request::parse rejected the request
+    // client_max_body_size and client_body_buffer_size for every request on this connection
+    void setBodyLimits(size_t maxBodySize, size_t bufferSize);
+    // Server block of the listener the connection was accepted on (index into Config::getServers)
+    void setServerIndex(size_t index);
+    size_t getServerIndex() const;
+    RequestBody& getRequestBody(); // Body of the current request (memory or temp file)
 
     // Response Handling
-    void setResponse(const Response& response); // Sets the response to be sent
-    ssize_t sendData(); // Sends data from _responseBuffer
-    bool isResponseFullySent() const;
+    void queueResponse(Response& response); // Appends the response's head and body segments to the output queue (takes the body)
+    ssize_t sendData(); // Flushes the output queue until it is empty or the socket is full
+    bool hasPendingOutput() const;
+    size_t getQueuedResponses() const;
+    bool hasWriteInterest() const; // EPOLLOUT currently registered with the poller
+    void setWriteInterest(bool enabled);
+
+    // Completion-based I/O (Poller::supportsCompletions): the poller performs the
+    // syscalls, the client builds their arguments and applies their results.
+    // Everything handed to the poller stays put until its completion arrives.
+    void appendReceived(BufferPool& pool, const char* data, size_t length); // Bytes a recv completion delivered
+    const struct msghdr* prepareSend(int& flags); // Gathers the front segments; NULL if a file range is first
+    char* prepareFileRead(int& fd, size_t& length, off_t& offset); // Chunk buffer for the front file range
+    ssize_t completeSend(int result);     // Like sendData(): bytes sent, or -1 if the connection must close
+    ssize_t completeFileRead(int result); // The bytes read become the front segment; -1 on error/short file
+    bool isSending() const;               // A send or file read is in flight
+    void setSending(bool sending);
+    unsigned getPendingOperations() const; // Completions the poller still owes this slot
+    void addPendingOperation();
+    void finishPendingOperation();
+    void markClosed(); // Socket closed with operations in flight: keep the buffers until they complete
+
+    // Persistent connections
+    bool isKeepAlive() const; // False once a response announced Connection: close
+    void setKeepAlive(bool keepAlive);
+    void clear(); // Reset for the next request; unconsumed (pipelined) bytes stay in _requestBuffer
+
+    // Timeouts (the node is linked into the Server's TimerWheel; it is never moved between clients)
+    TimerNode& getTimer();
+    ClientTimeout getTimeoutKind() const;
+    void setTimeoutKind(ClientTimeout kind);
+    unsigned long getRequestCount() const; // Requests processed on this connection
+    void incrementRequestCount();
+
+    // Memory accounting (worker_memory_limit)
+    size_t getBufferedBytes() const;   // Request bytes held plus response bytes still to send
+    size_t getAccountedBytes() const;  // What the server last added to its total for this client
+    void setAccountedBytes(size_t bytes);
 
 
 private:
@@ -56,14 +139,32 @@ private:
     struct sockaddr_in  _clientAddr;
     ClientState         _state;
     std::string         _requestBuffer; // Buffer for incoming request data
-    std::string         _responseBuffer; // Buffer for outgoing response data
-    size_t              _bytesSent;     // Track how much of _responseBuffer sent
+    std::deque<OutputSegment> _responseQueue; // Responses in request order
+    size_t              _bytesSent;     // Track how much of _responseQueue.front().data sent
+    size_t              _queuedResponses; // Responses with segments still in _responseQueue
     Request             _request;       // Parsed request object
-    bool                _requestParsed; // Flag to avoid re-parsing
+    RequestBody         _requestBody;   // Receives _request's body as it is decoded
+    bool                _keepAlive;     // Keep the connection open once the queued responses are sent
+    bool                _writeInterest; // EPOLLOUT registered
+    TimerNode           _timer;         // Intrusive TimerWheel entry
+    ClientTimeout       _timeoutKind;   // What _timer is currently armed for
+    unsigned long       _requestCount;  // Requests processed on this connection
+    size_t              _accountedBytes; // Share of the server's buffered-bytes total
+    bool                _hasInputBuffer; // _requestBuffer's storage was taken from the BufferPool
+    size_t              _serverIndex;   // Server block the connection belongs to
+
+    // Completion-based I/O state (the iovec/msghdr stay with the slot, like _timer)
+    struct iovec        _sendIov[MAX_IOV_SEGMENTS];
+    struct msghdr       _sendMsg;
+    std::string         _fileChunk;     // Target of the in-flight file read
+    bool                _sending;
+    unsigned            _pendingOperations;
 
+    void popSentSegment();
+    size_t gatherSegments(struct iovec* iov, int& flags) const; // Front in-memory segments, up to the first file range
+    void advanceSent(size_t bytes); // Pop the segments bytes completed, remember progress in the next one
+    void queueBlob(const std::shared_ptr<const std::string>& blob, size_t offset, size_t length);
 
-    // Private helper
-    void clear(); // Reset client state for reuse (if keep-alive)
 };
 
 #endif // CLIENT_HPP 
\ No newline at end of file
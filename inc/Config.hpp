@@ -2,8 +2,36 @@
 #define CONFIG_HPP
 
 #include <string>
+#include <vector>
 #include <map>
 
+#define DEFAULT_ROOT "./www/html" // Document root of a server block without a root directive
+
+// --- Parsed configuration structures ---
+struct LocationConfig {
+    std::string path;
+    std::string root;
+    std::vector<std::string> allowedMethods;
+    std::vector<std::string> indexFiles;
+    bool autoindex;
+    // ... other location directives (cgi, upload_path, return, limit_except etc.)
+
+    LocationConfig() : autoindex(false) {} // Default autoindex off
+};
+
+struct ServerConfig {
+    std::vector<std::pair<std::string, int> > listens; // host:port pairs
+    std::vector<std::string> serverNames;
+    std::string root; // Default root for the server
+    std::vector<std::string> indexFiles; // Default index files
+    std::map<int, std::string> errorPages; // map status code to path
+    size_t clientMaxBodySize;
+    size_t clientBodyBufferSize; // Larger bodies go to a temp file
+    std::vector<LocationConfig> locations;
+
+    ServerConfig() : clientMaxBodySize(1048576), clientBodyBufferSize(16384) {} // Default 1MB, 16KB
+};
+
 class Config {
 public:
     Config(const std::string& filename);
@@ -19,13 +47,71 @@ public:
     // size_t getClientMaxBodySize() const;
     // ... other getter methods based on subject requirements ...
 
+    const std::vector<ServerConfig>& getServers() const;
+    std::vector<std::pair<std::string, int> > getListeners() const; // Unique host:port pairs to bind
+    // Server block answering on listen: the first one that lists it (0 if none does)
+    size_t getServerIndex(const std::pair<std::string, int>& listen) const;
+    std::string getRoot(size_t server) const; // Document root of a server block, without a trailing '/'
+
+    // Global (outside any server block) settings
+    int getWorkerThreads() const; // Number of event loop threads (worker_threads N;)
+    int getWorkerProcesses() const; // Number of pre-forked worker processes, 0 = single process (worker_processes N;)
+    int getAcceptBatch() const; // Max connections accepted per listener wake-up (accept_batch N;)
+    int getWorkerConnections() const; // Client slab capacity per event loop (worker_connections N;)
+    const std::string& getEventBackend() const; // Readiness backend: "epoll" or "io_uring" (event_backend ...;)
+    // Connection timeouts in milliseconds (0 disables the timeout)
+    unsigned long getClientHeaderTimeoutMs() const; // Whole request head must arrive within this (client_header_timeout)
+    unsigned long getClientBodyTimeoutMs() const;   // Max gap between two body reads (client_body_timeout)
+    unsigned long getKeepaliveTimeoutMs() const;    // Idle time allowed between requests (keepalive_timeout)
+    unsigned long getSendTimeoutMs() const;         // Max gap between two successful writes (send_timeout)
+    unsigned long getKeepaliveRequests() const; // Max requests served on one connection (keepalive_requests N;)
+    // Overload protection
+    size_t getWorkerMemoryLimit() const; // Max bytes buffered for clients per event loop, 0 = unlimited (worker_memory_limit)
+    bool getOverload503() const;         // Shed excess connections with a static 503 instead of pausing accept (overload_503 on|off)
+    const std::string& getClientBodyTempPath() const; // Directory for request bodies over client_body_buffer_size
+    size_t getOpenFileCacheMax() const;            // Entries in the open_file_cache, 0 = off (open_file_cache max=N)
+    unsigned long getOpenFileCacheValidMs() const; // Age at which an entry is re-resolved (open_file_cache valid=T)
+    size_t getResponseCacheSize() const;           // Bytes of serialized small responses kept, 0 = off (response_cache_size)
+    const std::string& getEtag() const;            // ETag for static files: "on" (strong), "weak" or "off" (etag ...;)
+    // Compression of text types (text/*, application/javascript)
+    bool getGzipStatic() const;      // Serve a newer sibling .br/.gz when Accept-Encoding allows it (gzip_static on|off)
+    bool getGzip() const;            // Compress with zlib on the fly (gzip on|off)
+    size_t getGzipMinLength() const; // Smaller files are sent as they are (gzip_min_length)
+    size_t getGzipCacheSize() const; // Bytes of compressed responses kept so nothing is compressed twice (gzip_cache_size)
+    size_t getGzipMaxLength() const; // Larger files are sent as they are, never above gzip_cache_size (gzip_max_length)
+    size_t getSendfileThreshold() const; // Files at least this large are sent with sendfile(), smaller ones copied (sendfile_threshold)
+
 private:
     std::string _filename;
     // Data structures to store parsed configuration
-    // e.g., std::map<int, ServerConfig> _serverConfigs;
+    std::vector<ServerConfig> _servers;
+    int _workerThreads;
+    int _workerProcesses;
+    int _acceptBatch;
+    int _workerConnections;
+    std::string _eventBackend;
+    unsigned long _clientHeaderTimeoutMs;
+    unsigned long _clientBodyTimeoutMs;
+    unsigned long _keepaliveTimeoutMs;
+    unsigned long _sendTimeoutMs;
+    unsigned long _keepaliveRequests;
+    size_t _workerMemoryLimit;
+    bool _overload503;
+    std::string _clientBodyTempPath;
+    size_t _sendfileThreshold;
+    size_t _openFileCacheMax;
+    unsigned long _openFileCacheValidMs;
+    size_t _responseCacheSize;
+    std::string _etag;
+    bool _gzipStatic;
+    bool _gzip;
+    size_t _gzipMinLength;
+    size_t _gzipCacheSize;
+    size_t _gzipMaxLength; // 0: same as _gzipCacheSize
 
     // Private helper methods for parsing
     bool parseFile(); // Renamed from parseLine for clarity
+    bool parseGlobalDirective(const std::string& line, int lineNumber); // Top-level directives
     // ... other parsing helpers ...
 };
 
@@ -0,0 +1,28 @@
+#ifndef EPOLLPOLLER_HPP
+#define EPOLLPOLLER_HPP
+
+#include "Poller.hpp"
+
+#define EPOLL_BATCH_SIZE 64 // Max events fetched per epoll_wait call
+
+class EpollPoller : public Poller {
+public:
+    EpollPoller(); // Throws std::runtime_error if epoll_create1 fails
+    virtual ~EpollPoller();
+
+    virtual const char* name() const;
+    virtual void add(int fd, uint32_t events, EventHandler* handler);
+    virtual bool modify(int fd, uint32_t events, EventHandler* handler);
+    virtual void remove(int fd);
+    virtual int wait(PollerEvent* events, int maxEvents, int timeoutMs);
+
+private:
+    int _epollFd;
+    struct epoll_event _events[EPOLL_BATCH_SIZE]; // Buffer for epoll_wait events
+
+    // Prevent copying
+    EpollPoller(const EpollPoller&);
+    EpollPoller& operator=(const EpollPoller&);
+};
+
+#endif // EPOLLPOLLER_HPP
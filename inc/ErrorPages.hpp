@@ -0,0 +1,55 @@
+#ifndef ERRORPAGES_HPP
+#define ERRORPAGES_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>     // For std::shared_ptr
+#include <ctime>      // For time_t
+#include "Config.hpp"
+#include "Response.hpp"
+#include "ResponseCache.hpp"
+
+// Error responses prebuilt once at startup, per server block: the page body
+// (the configured error_page file, or the built-in HTML) and the whole
+// serialized response, so sending an error costs no allocation and no file I/O.
+// Blobs are handed out like ResponseCache entries: shared, never written while
+// queued, the Date value patched in place once per second.
+class ErrorPages {
+public:
+    ErrorPages();
+
+    // Build every page for every server block (error_page files read once here)
+    void load(const Config& config);
+
+    // Serialized response for code (no Connection header); false if it wasn't prebuilt
+    bool find(size_t vhost, int code, CachedResponse& out);
+    // Same page as a regular Response, for callers that add headers (416 Content-Range)
+    Response build(size_t vhost, int code) const;
+
+    // One of the codes pages are built for (reason phrases come from Response's status line table)
+    static bool isErrorCode(int code);
+
+private:
+    struct Entry {
+        std::string body;
+        std::shared_ptr<std::string> blob;
+        size_t headEnd;
+        size_t dateOffset; // Start of the Date value inside blob
+        time_t dateSecond; // Second the Date value shows
+
+        Entry() : headEnd(0), dateOffset(0), dateSecond(0) {}
+    };
+    typedef std::map<int, Entry> PageMap;
+
+    std::vector<PageMap> _pages; // Indexed like Config::getServers()
+
+    static std::string defaultBody(int code);
+    static bool readPage(const std::string& path, std::string& body);
+    static Response makeResponse(int code, const std::string& body);
+
+    ErrorPages(const ErrorPages&);
+    ErrorPages& operator=(const ErrorPages&);
+};
+
+#endif // ERRORPAGES_HPP
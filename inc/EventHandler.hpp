@@ -0,0 +1,30 @@
+#ifndef EVENTHANDLER_HPP
+#define EVENTHANDLER_HPP
+
+#include <cstddef> // For size_t
+
+// Tag stored behind epoll_event.data.ptr: the event loop reads the type and
+// casts straight to the owning object, so dispatch needs no fd lookup at all.
+struct EventHandler {
+    enum Type {
+        LISTENER, // ListenerHandler: a listening socket
+        CLIENT,   // Client: an accepted connection (lives in the Server's slab)
+        CGI_PIPE,  // Reserved for CGI stdout/stdin pipes
+        FILE_CACHE, // OpenFileCache: its inotify descriptor
+        WAKEUP     // Server: eventfd another thread writes to (see Server::requestDrain)
+    };
+
+    Type handlerType;
+
+    explicit EventHandler(Type type) : handlerType(type) {}
+};
+
+// Handler for a listening socket (owned by Server, one per listener)
+struct ListenerHandler : public EventHandler {
+    int fd;
+    size_t server; // Index of the server block it belongs to (Config::getServerIndex)
+
+    ListenerHandler(int listenerFd, size_t serverIndex) : EventHandler(LISTENER), fd(listenerFd), server(serverIndex) {}
+};
+
+#endif // EVENTHANDLER_HPP
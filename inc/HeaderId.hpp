@@ -0,0 +1,58 @@
+#ifndef HEADERID_HPP
+#define HEADERID_HPP
+
+#include <cstddef> // For size_t
+
+// Well-known header fields, resolved once at parse time so lookups are an array
+// index instead of a case-insensitive string compare.
+enum HeaderId {
+    HEADER_UNKNOWN = 0,
+    HEADER_ACCEPT,
+    HEADER_ACCEPT_ENCODING,
+    HEADER_ACCEPT_LANGUAGE,
+    HEADER_ACCEPT_RANGES,
+    HEADER_AUTHORIZATION,
+    HEADER_CACHE_CONTROL,
+    HEADER_CONNECTION,
+    HEADER_CONTENT_ENCODING,
+    HEADER_CONTENT_LENGTH,
+    HEADER_CONTENT_RANGE,
+    HEADER_CONTENT_TYPE,
+    HEADER_COOKIE,
+    HEADER_DATE,
+    HEADER_ETAG,
+    HEADER_EXPECT,
+    HEADER_HOST,
+    HEADER_IF_MATCH,
+    HEADER_IF_MODIFIED_SINCE,
+    HEADER_IF_NONE_MATCH,
+    HEADER_IF_RANGE,
+    HEADER_IF_UNMODIFIED_SINCE,
+    HEADER_KEEP_ALIVE,
+    HEADER_LAST_MODIFIED,
+    HEADER_LOCATION,
+    HEADER_RANGE,
+    HEADER_REFERER,
+    HEADER_RETRY_AFTER,
+    HEADER_SERVER,
+    HEADER_TE,
+    HEADER_TRAILER,
+    HEADER_TRANSFER_ENCODING,
+    HEADER_UPGRADE,
+    HEADER_USER_AGENT,
+    HEADER_VARY,
+    HEADER_COUNT
+};
+
+class KnownHeaders {
+public:
+    // Perfect hash over the names above (case-insensitive); HEADER_UNKNOWN otherwise
+    static HeaderId lookup(const char* name, size_t length);
+    // Canonical spelling, e.g. "Content-Length"
+    static const char* name(HeaderId id);
+
+private:
+    KnownHeaders();
+};
+
+#endif // HEADERID_HPP
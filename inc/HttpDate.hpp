@@ -0,0 +1,27 @@
+#ifndef HTTPDATE_HPP
+#define HTTPDATE_HPP
+
+#include <ctime> // For time_t
+#include <string>
+
+#define HTTP_DATE_LENGTH 29 // "Sun, 06 Nov 1994 08:49:37 GMT"
+
+// Value of the Date header for the current second. Each event loop refreshes it
+// once per iteration and it is only reformatted when the second changes, so
+// responses copy 29 bytes instead of calling time()/gmtime()/strftime().
+// The storage is thread_local: every worker thread runs its own loop.
+class HttpDate {
+public:
+    static void refresh();        // Re-read the wall clock (coarse, no syscall via the vDSO)
+    static const char* current(); // NUL-terminated, HTTP_DATE_LENGTH characters
+    static time_t now();          // The second current() shows
+
+    static std::string format(time_t when); // IMF-fixdate, e.g. for Last-Modified
+    // IMF-fixdate, or the obsolete RFC 850 / asctime forms; false if it is none of them
+    static bool parse(const std::string& value, time_t& when);
+
+private:
+    HttpDate();
+};
+
+#endif // HTTPDATE_HPP
@@ -0,0 +1,111 @@
+#ifndef IOURINGPOLLER_HPP
+#define IOURINGPOLLER_HPP
+
+#include "Poller.hpp"
+#include <vector>
+#include <linux/io_uring.h>
+
+#define IOURING_QUEUE_DEPTH 256 // Submission queue entries (completion queue is twice this)
+#define IOURING_RECV_BUFFERS 256 // Provided buffers multishot recvs land in (a power of two)
+#define IOURING_RECV_BUFFER_SIZE 16384
+#define IOURING_BUFFER_GROUP 0
+
+// io_uring backend (event_backend io_uring;), driven through the raw syscalls so
+// no liburing dependency is needed.
+//
+// Completion mode (Linux 6.1+): the ring performs the socket I/O itself. Each
+// listener has one multishot IORING_OP_ACCEPT and each connection one multishot
+// IORING_OP_RECV, which picks a buffer from a ring of provided buffers when data
+// arrives, so idle connections hold none. Responses go out as IORING_OP_SENDMSG
+// (file ranges are read with IORING_OP_READ first: sendfile() has no ring opcode).
+// Closing queues ASYNC_CANCEL and CLOSE. All of it is submitted together with the
+// wait itself, so a keep-alive request costs one io_uring_enter() at most.
+//
+// Readiness mode (older kernels, and fds like inotify/eventfd in either mode):
+// every registered fd has a one-shot IORING_OP_POLL_ADD in flight. Registrations,
+// re-arms, interest changes (POLL_REMOVE + POLL_ADD) and removals are queued as
+// SQEs and submitted with the wait, instead of one epoll_ctl() per change.
+//
+// Polls are one-shot and re-armed after each completion, so readiness is
+// level-triggered: EPOLLET is accepted and ignored. EPOLLEXCLUSIVE has no
+// equivalent and is refused (Config rejects io_uring with worker_processes).
+class IoUringPoller : public Poller {
+public:
+    IoUringPoller(); // Throws std::runtime_error if io_uring is unavailable
+    virtual ~IoUringPoller();
+
+    virtual const char* name() const;
+    virtual void add(int fd, uint32_t events, EventHandler* handler);
+    virtual bool modify(int fd, uint32_t events, EventHandler* handler);
+    virtual void remove(int fd);
+    virtual int wait(PollerEvent* events, int maxEvents, int timeoutMs);
+
+    virtual bool supportsCompletions() const;
+    virtual bool acceptMultishot(int listenerFd, EventHandler* handler);
+    virtual bool recvMultishot(int fd, EventHandler* handler);
+    virtual bool sendMsg(int fd, const struct msghdr* msg, int flags, EventHandler* handler);
+    virtual bool read(int fd, void* buffer, size_t length, off_t offset, EventHandler* handler);
+    virtual void cancel(int fd);
+    virtual void cancelAndClose(int fd);
+
+private:
+    // Per-fd registration, indexed by fd
+    struct Registration {
+        EventHandler* handler;
+        uint32_t events;     // Interest mask (POLLIN/POLLOUT bits)
+        uint32_t generation; // Bumped on every (re)registration; stale completions are ignored
+        bool active;         // Registered by the caller
+        bool armed;          // A POLL_ADD for the current generation is in flight
+
+        Registration() : handler(NULL), events(0), generation(0), active(false), armed(false) {}
+    };
+
+    int _ringFd;
+
+    // Submission queue ring
+    void* _sqRingPtr;
+    size_t _sqRingSize;
+    unsigned* _sqHead;
+    unsigned* _sqTail;
+    unsigned* _sqRingMask;
+    unsigned* _sqArray;
+    struct io_uring_sqe* _sqes;
+    size_t _sqesSize;
+
+    // Completion queue ring (shares the SQ mapping on IORING_FEAT_SINGLE_MMAP kernels)
+    void* _cqRingPtr;
+    size_t _cqRingSize;
+    unsigned* _cqHead;
+    unsigned* _cqTail;
+    unsigned* _cqRingMask;
+    struct io_uring_cqe* _cqes;
+
+    std::vector<Registration> _registrations;
+    std::vector<int> _rearm; // fds whose one-shot poll fired and must be re-armed
+
+    // Provided buffers for multishot recv (completion mode only)
+    bool _completions;
+    struct io_uring_buf_ring* _bufRing; // Shared with the kernel
+    size_t _bufRingSize;
+    std::vector<char> _recvBuffers;      // IOURING_RECV_BUFFERS * IOURING_RECV_BUFFER_SIZE
+    unsigned short _bufRingTail;
+    std::vector<unsigned short> _usedBuffers; // Handed out by the last wait(), returned by the next
+
+    bool setupCompletions(); // Probe the opcodes and register the buffer ring
+    void provideBuffer(unsigned short bid);
+
+    struct io_uring_sqe* getSqe(); // Next free SQE, flushing the queue if it is full
+    unsigned pendingSubmissions() const;
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, int timeoutMs);
+    void queuePollAdd(int fd);
+    void queuePollRemove(int fd);
+    struct io_uring_sqe* queueOperation(int opcode, int fd, EventHandler* handler, PollerOp op);
+    bool queueCancel(int fd, unsigned char sqeFlags);
+    Registration& registration(int fd);
+
+    // Prevent copying
+    IoUringPoller(const IoUringPoller&);
+    IoUringPoller& operator=(const IoUringPoller&);
+};
+
+#endif // IOURINGPOLLER_HPP
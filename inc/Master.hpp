@@ -0,0 +1,46 @@
+#ifndef MASTER_HPP
+#define MASTER_HPP
+
+#include "Config.hpp"
+#include "Socket.hpp"
+#include <vector>
+#include <csignal>    // For sig_atomic_t
+#include <sys/types.h> // For pid_t
+
+// Pre-fork process model (worker_processes N;):
+// the master binds every listener from the Config once, forks N workers that each
+// run their own Server event loop on the inherited fds, and respawns any worker
+// that dies unexpectedly.
+class Master {
+public:
+    Master(const Config& config);
+    ~Master();
+
+    // Bind listeners, fork workers and supervise them until SIGINT/SIGTERM
+    // (stop now) or SIGQUIT (let workers drain). SIGUSR2 starts a binary upgrade.
+    void run();
+
+private:
+    const Config& _config;
+    std::vector<Socket> _listeningSockets; // Bound once here, inherited by every worker
+    std::vector<pid_t> _workers;           // Worker slot -> pid (-1 if not running)
+    pid_t _newBinary;                      // Binary started by SIGUSR2 (-1 if none)
+
+    static volatile sig_atomic_t _stopRequested;
+    static volatile sig_atomic_t _drainRequested;
+    static volatile sig_atomic_t _upgradeRequested;
+    static void signalHandler(int signum);
+
+    bool bindListeners();
+    void installSignalHandlers();
+    pid_t spawnWorker(size_t slot);
+    void superviseWorkers();
+    void stopWorkers();
+    void drainWorkers();
+
+    // Prevent copying
+    Master(const Master&);
+    Master& operator=(const Master&);
+};
+
+#endif // MASTER_HPP
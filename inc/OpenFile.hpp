@@ -0,0 +1,28 @@
+#ifndef OPENFILE_HPP
+#define OPENFILE_HPP
+
+#include <cstddef>    // For size_t
+#include <ctime>      // For time_t
+#include <unistd.h>   // For close
+
+// A file opened for a response body. Held through std::shared_ptr by every
+// response (and queued output segment) sending from it; the descriptor is
+// closed when the last of them lets go.
+struct OpenFile {
+    int fd;
+    size_t size;
+    time_t mtime;
+
+    OpenFile(int fileFd, size_t fileSize, time_t modified) : fd(fileFd), size(fileSize), mtime(modified) {}
+    ~OpenFile() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+private:
+    OpenFile(const OpenFile&);
+    OpenFile& operator=(const OpenFile&);
+};
+
+#endif // OPENFILE_HPP
@@ -0,0 +1,78 @@
+#ifndef OPENFILECACHE_HPP
+#define OPENFILECACHE_HPP
+
+#include <string>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <memory>     // For std::shared_ptr
+#include <stdint.h>   // For uint64_t
+#include "OpenFile.hpp"
+#include "EventHandler.hpp"
+
+// Outcome of resolving a request path against the docroot (index files applied)
+struct FileLookup {
+    int status;                      // 200, or 403/404 for the error response (500s are never cached)
+    std::shared_ptr<OpenFile> file;  // Open descriptor, size and mtime; cached 200s always have it,
+                                     // a fresh resolution only once a body is going to be sent
+    std::string path;                // The file resolved to (index file for a directory)
+    std::string contentType;
+    std::string etag;                // Validators computed once per resolution (etag empty when off)
+    std::string lastModified;
+    time_t mtime;                    // What lastModified shows, known before the file is opened
+    bool isDirectory;                // Path named a directory (served through an index file, or not at all)
+
+    FileLookup() : status(404), mtime(0), isDirectory(false) {}
+};
+
+// open_file_cache: path -> FileLookup, so a hot static file costs one hash lookup
+// instead of stat() per index candidate plus open(). Entries are LRU-evicted past
+// maxEntries and expire validMs after they were resolved. The directories they
+// live in are watched with inotify, so edits, deletes and creations invalidate
+// the affected entries at once; the TTL only matters if a watch can't be added.
+// The inotify fd is registered with the Server's poller (handler type FILE_CACHE).
+class OpenFileCache : public EventHandler {
+public:
+    OpenFileCache(size_t maxEntries, unsigned long validMs);
+    ~OpenFileCache();
+
+    bool isEnabled() const;
+    int getWatchFd() const; // inotify descriptor, -1 if unavailable
+
+    // Cached result for path, NULL on a miss. Valid until the next insert() or processEvents().
+    const FileLookup* find(const std::string& path, uint64_t nowMs);
+    void insert(const std::string& path, const FileLookup& result, uint64_t nowMs);
+    void processEvents(); // Drain the inotify fd and drop the entries it names
+
+    size_t size() const;
+    unsigned long getHits() const;
+    unsigned long getMisses() const;
+
+private:
+    struct Entry {
+        std::string path;
+        FileLookup result;
+        uint64_t expiresMs;
+    };
+    typedef std::list<Entry> EntryList; // Most recently used first
+
+    size_t _maxEntries;
+    unsigned long _validMs;
+    EntryList _lru;
+    std::unordered_map<std::string, EntryList::iterator> _index;
+    int _inotifyFd;
+    std::map<int, std::string> _watchDirs;      // Watch descriptor -> directory
+    std::map<std::string, int> _watchedPaths;   // Directory -> watch descriptor
+    unsigned long _hits;
+    unsigned long _misses;
+
+    void watchDirectory(const std::string& dir);
+    void invalidate(const std::string& path);
+    void invalidateDirectory(const std::string& dir, const std::string& name);
+    void clear();
+
+    OpenFileCache(const OpenFileCache&);
+    OpenFileCache& operator=(const OpenFileCache&);
+};
+
+#endif // OPENFILECACHE_HPP
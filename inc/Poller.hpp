@@ -0,0 +1,75 @@
+#ifndef POLLER_HPP
+#define POLLER_HPP
+
+#include "EventHandler.hpp"
+#include <string>
+#include <stdint.h>    // For uint32_t
+#include <sys/types.h> // For off_t
+#include <sys/epoll.h> // Event flags (EPOLLIN, EPOLLOUT, ...) are shared by every backend
+
+struct msghdr;
+
+// What a PollerEvent reports: readiness of a registered fd, or the result of an
+// operation queued with one of the completion calls below
+enum PollerOp {
+    POLLER_READY,  // events holds what happened to the fd
+    POLLER_ACCEPT, // result: the accepted fd
+    POLLER_RECV,   // result: bytes received into data (0 = peer closed)
+    POLLER_SEND,   // result: bytes sent
+    POLLER_READ    // result: bytes read from the file
+};
+
+// One event: the handler registered for the fd (or passed with the operation)
+// and what happened. Event bits use the EPOLL* values (EPOLLIN/EPOLLOUT/EPOLLERR/
+// EPOLLHUP), which are numerically the same as POLLIN/POLLOUT/POLLERR/POLLHUP.
+struct PollerEvent {
+    EventHandler* handler;
+    uint32_t events;
+    PollerOp op;
+    int result;       // Completions: what the syscall returned, or -errno
+    const char* data; // POLLER_RECV: the received bytes, valid until the next wait()
+    bool more;        // Completions: a multishot operation is still armed
+};
+
+// Event backend used by Server's event loop.
+// Implementations: EpollPoller (default) and IoUringPoller. Selected with
+// the global "event_backend epoll|io_uring;" directive.
+class Poller {
+public:
+    virtual ~Poller() {}
+
+    virtual const char* name() const = 0;
+
+    // Register fd. Throws std::runtime_error on failure.
+    virtual void add(int fd, uint32_t events, EventHandler* handler) = 0;
+    // Change the interest set of a registered fd. Returns false on failure.
+    virtual bool modify(int fd, uint32_t events, EventHandler* handler) = 0;
+    // Unregister fd (call before closing it).
+    virtual void remove(int fd) = 0;
+    // Wait up to timeoutMs (-1 = forever) and fill at most maxEvents entries.
+    // Returns the number of events, or -1 with errno set.
+    virtual int wait(PollerEvent* events, int maxEvents, int timeoutMs) = 0;
+
+    // Completion-based I/O, for backends that perform the syscalls themselves
+    // (io_uring). Operations are queued and submitted with the next wait(), which
+    // reports their results; buffers and msghdrs must stay valid until then.
+    // They return false if the operation can't be queued. Readiness-only backends
+    // report false from supportsCompletions() and are never asked for them.
+    virtual bool supportsCompletions() const { return false; }
+    // Accept on listenerFd until cancelled (the accepted sockets are blocking)
+    virtual bool acceptMultishot(int, EventHandler*) { return false; }
+    // Receive into the backend's buffers until EOF, an error or cancellation
+    virtual bool recvMultishot(int, EventHandler*) { return false; }
+    virtual bool sendMsg(int, const struct msghdr*, int, EventHandler*) { return false; }
+    virtual bool read(int, void*, size_t, off_t, EventHandler*) { return false; }
+    // Cancel every operation on fd, before returning (the caller may close fd next)
+    virtual void cancel(int) {}
+    // Cancel every operation on fd, then close it, with the next wait()
+    virtual void cancelAndClose(int) {}
+
+    // Factory: builds the requested backend, falling back to epoll if it is
+    // unavailable (e.g., io_uring disabled by the kernel). Throws if nothing works.
+    static Poller* create(const std::string& backend);
+};
+
+#endif // POLLER_HPP
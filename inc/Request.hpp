@@ -2,40 +2,121 @@
 #define REQUEST_HPP
 
 #include <string>
-#include <map>
 #include <vector>
+#include <cstddef> // For size_t
+#include "HeaderId.hpp"
+#include "BodyConsumer.hpp"
+
+#define MAX_REQUEST_LINE 8192  // Longer request lines are rejected with 414
+#define MAX_REQUEST_HEAD 32768 // Request line + headers beyond this are rejected with 431
+#define MAX_REQUEST_HEADERS 100 // More header fields than this are rejected with 431
+#define MAX_CHUNK_LINE 4096     // Chunk-size line (with extensions) longer than this is rejected with 400
 
 class Request {
 public:
+    // Resumable parser: each parse() call continues where the previous one stopped
+    enum ParseState {
+        ParsingRequestLine,
+        ParsingHeaders,
+        ParsingBody,
+        Complete,
+        Error
+    };
+
+    // Byte range inside the connection buffer the request is parsed from
+    struct Span {
+        size_t offset;
+        size_t length;
+        Span() : offset(0), length(0) {}
+        Span(size_t o, size_t l) : offset(o), length(l) {}
+    };
+
+    struct HeaderField {
+        HeaderId id; // HEADER_UNKNOWN for names outside the well-known set
+        Span name;
+        Span value;
+    };
+
     Request();
     ~Request();
 
-    // Parsing function (placeholder - complex logic needed)
-    bool parse(const std::string& rawRequest);
+    // Scan only the bytes appended to buffer since the previous call.
+    // buffer must be the same connection buffer each time, only appended to by the
+    // caller while this request is being parsed: fields are stored as offsets into it.
+    // The body is decoded in place: chunk framing (and bytes handed to the body
+    // consumer) are cut out of buffer, so it only ever holds the decoded body.
+    ParseState parse(std::string& buffer);
+    // Start over for the next request on the connection (keeps the header array's
+    // capacity, the body size limit and the body consumer)
+    void reset();
 
-    // Accessors
-    const std::string& getMethod() const;
-    const std::string& getPath() const;
-    const std::string& getVersion() const;
-    std::string getHeader(const std::string& key) const; // Case-insensitive lookup?
-    const std::map<std::string, std::string>& getHeaders() const;
-    const std::string& getBody() const;
+    void setMaxBodySize(size_t bytes); // client_max_body_size, 0 = unlimited; exceeding it fails with 413
+    void setBodyConsumer(BodyConsumer* consumer); // NULL keeps the body in the connection buffer
 
-    // Mutators (used during parsing or potentially by server)
-    void setMethod(const std::string& method);
-    void setPath(const std::string& path);
-    void setVersion(const std::string& version);
-    void addHeader(const std::string& key, const std::string& value);
-    void setBody(const std::string& body);
+    ParseState getState() const;
+    int getErrorCode() const; // 400, 413, 414, 431, 500, 501 or 505 once getState() == Error
+    bool hasCompleteHeaders() const;
 
+    // Accessors (materialize the spans; valid after parse() reached Complete)
+    std::string getMethod() const;
+    std::string getPath() const;
+    std::string getVersion() const;
+    const HeaderField* findHeader(HeaderId id) const; // First field with that id, O(1); NULL if absent
+    std::string getHeader(HeaderId id) const;
+    std::string getHeader(const std::string& key) const; // Case-insensitive, first occurrence
+    // Case-insensitive match of one element of a comma-separated header (e.g. Connection: close)
+    bool headerHasToken(HeaderId id, const char* token) const;
+    const std::vector<HeaderField>& getHeaderFields() const;
+    std::string getBody() const; // Decoded body, empty if it went to a body consumer
+    size_t getBodyLength() const; // Decoded body bytes received so far
+    bool isChunked() const;
+    size_t getRequestLength() const; // Bytes of the buffer this request occupies (head + decoded body)
+    bool wantsKeepAlive() const; // HTTP/1.1 unless "Connection: close", HTTP/1.0 only with "Connection: keep-alive"
 
 private:
-    std::string _method;
-    std::string _path;
-    std::string _version;
-    std::map<std::string, std::string> _headers;
-    std::string _body;
-    // Internal parsing state if needed
+    const std::string* _buffer; // Connection buffer of the last parse() call
+    ParseState _state;
+    int _errorCode;
+    size_t _scanOffset;  // Next byte not looked at yet
+    size_t _lineStart;   // Start of the line being parsed
+    size_t _headStart;   // Start of the request line (after any leading blank lines)
+
+    Span _method;
+    Span _path;
+    Span _version;
+    std::vector<HeaderField> _headers; // In arrival order, one contiguous block
+    unsigned char _headerIndex[HEADER_COUNT]; // 1 + position in _headers of the first field per id, 0 = absent
+    size_t _bodyStart;
+    size_t _contentLength;
+    size_t _requestLength;
+
+    // Body decoding. During ParsingBody _lineStart is the first raw byte not consumed
+    // yet and _bodyEnd the end of the decoded body kept in the buffer.
+    enum ChunkState {
+        ChunkSize,    // Expecting "hex-size[;ext...]" CRLF
+        ChunkData,    // _chunkRemaining data bytes to go
+        ChunkDataEnd, // Expecting the CRLF after the chunk data
+        ChunkTrailer  // Trailer field lines until an empty line
+    };
+    bool _chunked;
+    ChunkState _chunkState;
+    size_t _chunkRemaining;
+    size_t _trailerBytes;
+    size_t _bodyEnd;
+    size_t _bodyLength;
+    size_t _maxBodySize;
+    BodyConsumer* _bodyConsumer;
+
+    ParseState fail(int errorCode);
+    bool parseRequestLine(size_t lineEnd);
+    bool parseFieldLine(size_t lineEnd, HeaderField& field);
+    bool parseHeaderLine(size_t lineEnd);
+    bool finishHeaders();
+    void parseBody(std::string& buffer);
+    bool parseChunkLine(size_t lineEnd);
+    bool deliverBody(char* data, size_t offset, size_t length);
+    void compactBody(std::string& buffer);
+    std::string spanToString(const Span& span) const;
 };
 
-#endif // REQUEST_HPP 
\ No newline at end of file
+#endif // REQUEST_HPP
@@ -0,0 +1,50 @@
+#ifndef REQUESTBODY_HPP
+#define REQUESTBODY_HPP
+
+#include <string>
+#include <cstddef> // For size_t
+#include "BodyConsumer.hpp"
+
+#define DEFAULT_BODY_TEMP_PATH "/tmp"
+
+// Where a request body ends up: kept in memory up to client_body_buffer_size,
+// then moved to an anonymous temp file (O_TMPFILE, nothing to clean up) and
+// appended to as it streams in. Handlers read it through getFd().
+class RequestBody : public BodyConsumer {
+public:
+    RequestBody();
+    ~RequestBody();
+
+    RequestBody(RequestBody&& other) noexcept;
+    RequestBody& operator=(RequestBody&& other) noexcept;
+    RequestBody(const RequestBody&) = delete;
+    RequestBody& operator=(const RequestBody&) = delete;
+
+    // Directory for spilled bodies (client_body_temp_path); set once at startup
+    static void setTempDirectory(const std::string& path);
+
+    void setBufferSize(size_t bytes); // In-memory threshold (client_body_buffer_size)
+    bool consume(const char* data, size_t length);
+    void reset(); // Drop the body (closing its temp file) before the next request
+
+    size_t getSize() const;
+    bool isInFile() const;
+    const std::string& getMemory() const; // The body while !isInFile()
+    // The body as a file rewound to offset 0; an in-memory body is written out first.
+    // Owned by the RequestBody (closed by reset()); -1 on error.
+    int getFd();
+    size_t getBufferedBytes() const; // Memory held, for worker_memory_limit
+
+private:
+    std::string _memory;
+    int _fd;
+    size_t _size;
+    size_t _bufferSize;
+
+    static std::string _tempDirectory;
+
+    bool spill();
+    bool writeAll(const char* data, size_t length);
+};
+
+#endif // REQUESTBODY_HPP
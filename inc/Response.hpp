@@ -2,36 +2,93 @@
 #define RESPONSE_HPP
 
 #include <string>
-#include <map>
 #include <vector>
+#include <memory> // For std::shared_ptr
+#include <sys/types.h> // For off_t
+#include "HeaderId.hpp"
+#include "OpenFile.hpp"
+#include "ResponseCache.hpp"
 
 class Response {
 public:
+    // Precomputed "HTTP/1.1 <code> <reason>\r\n" (see STATUS_LINES in Response.cpp)
+    struct StatusLine {
+        int code;
+        const char* reason;
+        const char* line;
+        size_t length;
+    };
+
+    // Body piece queued after the in-memory body: text, or a range of file when it is set
+    struct BodyPart {
+        std::string text;
+        std::shared_ptr<OpenFile> file;
+        off_t fileOffset;
+        size_t fileLength;
+    };
+
     Response();
     ~Response();
+    Response(const Response&) = default;
+    Response& operator=(const Response&) = default;
+    Response(Response&&) = default;            // Bodies move, they are never copied on the way out
+    Response& operator=(Response&&) = default;
 
     // Setters
     void setVersion(const std::string& version);
     void setStatusCode(int code, const std::string& message = "");
-    void setHeader(const std::string& key, const std::string& value);
+    void setHeader(HeaderId id, const std::string& value); // Well-known header, no name lookup
+    void setHeader(const std::string& key, const std::string& value); // Replaces an existing header (case-insensitive)
     void setBody(const std::string& body);
+    void setBody(std::string&& body);
+    // Body sent straight from a file with sendfile() instead of being copied into _body
+    void setBodyFile(const std::shared_ptr<OpenFile>& file, off_t offset, size_t length);
+    // Multi-part bodies (multipart/byteranges): pieces sent in order after _body,
+    // each either in-memory text or a file range that goes out with sendfile()
+    void addBodyPart(const std::string& text);
+    void addBodyPart(const std::shared_ptr<OpenFile>& file, off_t offset, size_t length);
+    // Already serialized response from the ResponseCache: queued by reference, only
+    // the Connection header set on this object is added when sending
+    void setCached(const CachedResponse& cached);
 
     // Getters (optional)
     int getStatusCode() const;
     const std::string& getBody() const;
+    std::string takeBody(); // Moves the in-memory body out (Client queues it as its own segment)
+    const std::vector<BodyPart>& getBodyParts() const; // Empty unless setBodyFile()/addBodyPart() was used
+    const CachedResponse& getCached() const; // blob is NULL unless setCached() was used
+    std::string getHeader(HeaderId id) const; // Empty if not set
+    // Reason phrase from the status line table, "Unknown Status" for codes outside it
+    static std::string getDefaultStatusMessage(int code);
 
-    // Generate the full HTTP response string
+    // Generate the HTTP response string: status line, headers and the in-memory body
+    // (a file body is queued separately, see Client::queueResponse)
     std::string toString() const;
+    // Status line and headers only, appended to out (the body is queued after them).
+    // withConnection false leaves out Connection, which differs per connection (ResponseCache).
+    void appendHead(std::string& out, bool withConnection = true) const;
+    std::string toCacheableString() const; // appendHead(out, false) plus the in-memory body
 
 private:
     std::string _version;
+    bool _defaultVersion; // _version is HTTP/1.1: the precomputed status lines apply
     int _statusCode;
     std::string _statusMessage;
-    std::map<std::string, std::string> _headers;
+    const StatusLine* _statusLine; // NULL for codes (or reason phrases) outside the table
+    // Headers in insertion order; well-known ones carry only their id, the name comes from KnownHeaders
+    struct HeaderEntry {
+        HeaderId id;
+        std::string name; // Only for HEADER_UNKNOWN
+        std::string value;
+    };
+    std::vector<HeaderEntry> _headers;
+    unsigned long long _headerMask; // Bit per HeaderId present in _headers
     std::string _body;
+    std::vector<BodyPart> _bodyParts;
+    size_t _bodyPartsLength; // Bytes of all _bodyParts (for Content-Length)
+    CachedResponse _cached;
 
-    // Helper to get default status message
-    std::string getDefaultStatusMessage(int code);
+    static const StatusLine* findStatusLine(int code);
 };
 
 #endif // RESPONSE_HPP 
\ No newline at end of file
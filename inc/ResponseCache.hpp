@@ -0,0 +1,76 @@
+#ifndef RESPONSECACHE_HPP
+#define RESPONSECACHE_HPP
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>     // For std::shared_ptr, std::weak_ptr
+#include <ctime>      // For time_t
+#include "OpenFile.hpp"
+#include "HttpDate.hpp"
+
+// Serialized response handed out by the ResponseCache. The blob is shared with
+// the cache and every output queue sending it; nobody writes to it while shared.
+struct CachedResponse {
+    std::shared_ptr<const std::string> blob; // Status line, headers (no Connection) and body
+    size_t headEnd; // Offset of the blank line ending the head: Connection goes in before it
+
+    CachedResponse() : headEnd(0) {}
+};
+
+// Micro-cache of fully serialized small static responses, keyed by vhost,
+// resolved path and content encoding. An entry remembers the OpenFile it was
+// built from and only matches while the open_file_cache still resolves the path
+// to that same file, so inotify invalidation and open_file_cache valid= carry
+// over. Entries are LRU-evicted once their total size passes maxBytes.
+// The Date header is the only part that changes: it is rewritten in place once
+// per second, or in a fresh copy while an older blob is still being sent.
+class ResponseCache {
+public:
+    explicit ResponseCache(size_t maxBytes);
+
+    bool isEnabled() const;
+
+    static std::string makeKey(size_t vhost, const std::string& path, const std::string& encoding);
+
+    // Serialized response for key built from file, with the current HttpDate; false on a miss
+    bool find(const std::string& key, const std::shared_ptr<OpenFile>& file, CachedResponse& out);
+    // Remember a response just serialized (must contain a Date header and no Connection header)
+    void insert(const std::string& key, const std::shared_ptr<OpenFile>& file, const std::string& serialized);
+
+    // Shared with other holders of serialized responses (ErrorPages):
+    // where the head ends and the Date value starts; false if there is no Date to patch
+    static bool locate(const std::string& serialized, size_t& headEnd, size_t& dateOffset);
+    // Bring the Date value up to HttpDate::now(), on a fresh copy if blob is still queued somewhere
+    static void refreshDate(std::shared_ptr<std::string>& blob, size_t dateOffset, time_t& dateSecond);
+
+    size_t size() const;
+    size_t getBytes() const;
+    unsigned long getHits() const;
+    unsigned long getMisses() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::weak_ptr<OpenFile> source; // Doesn't keep the descriptor open
+        std::shared_ptr<std::string> blob;
+        size_t headEnd;
+        size_t dateOffset; // Start of the Date value inside blob
+        time_t dateSecond; // Second the Date value shows
+    };
+    typedef std::list<Entry> EntryList; // Most recently used first
+
+    size_t _maxBytes;
+    size_t _bytes;
+    EntryList _lru;
+    std::unordered_map<std::string, EntryList::iterator> _index;
+    unsigned long _hits;
+    unsigned long _misses;
+
+    void erase(EntryList::iterator entry);
+
+    ResponseCache(const ResponseCache&);
+    ResponseCache& operator=(const ResponseCache&);
+};
+
+#endif // RESPONSECACHE_HPP
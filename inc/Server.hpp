@@ -4,50 +4,155 @@
 #include "Config.hpp" // Need full definition now
 #include "Socket.hpp"
 #include "Client.hpp" // Include the new Client header
+#include "EventHandler.hpp"
+#include "Poller.hpp"
+#include "TimerWheel.hpp"
+#include "BufferPool.hpp"
+#include "OpenFileCache.hpp"
+#include "ResponseCache.hpp"
+#include "ErrorPages.hpp"
 #include <vector>
-#include <map>
-#include <sys/epoll.h> // For epoll
+#include <memory> // For std::unique_ptr
+#include <atomic> // For std::atomic
+#include <csignal> // For sig_atomic_t
+#include <sys/types.h> // For pid_t
 
-#define MAX_EVENTS 10 // Max events to handle at once in epoll_wait
+#define MAX_EVENTS 64 // Max events to handle at once per Poller::wait
 
 class Server {
 public:
     // Constructor takes the fully loaded Config object
     Server(const Config& config);
+    // Worker-process variant: adopt listening fds already bound by the master
+    // instead of binding new ones (registered with EPOLLEXCLUSIVE).
+    Server(const Config& config, const std::vector<int>& inheritedListeners);
     ~Server();
 
-    // Initialize server (sockets, epoll)
+    // Initialize server (sockets, poller)
     bool init();
-    // Main server loop
+    // Main server loop; returns once a graceful drain (SIGQUIT) has closed every client
     void run();
 
+    // SIGQUIT: stop accepting, finish in-flight requests, exit when idle.
+    // SIGUSR2 (if handleUpgrade): exec the new binary with our listeners (see Upgrade).
+    static void installSignalHandlers(bool handleUpgrade);
+    // SIGQUIT for this server alone, from another thread (worker_threads: the main
+    // thread takes the signals and calls this on every server)
+    void requestDrain();
+
 private:
     // Configuration
     const Config& _config;
 
     // Networking
     std::vector<Socket> _listeningSockets; // Store multiple listening sockets
-    std::map<int, Client> _clients; // Use std::map<int, Client> to store client state
-    int _epollFd;                         // epoll instance file descriptor
-    struct epoll_event _events[MAX_EVENTS]; // Buffer for epoll_wait events
+    std::vector<int> _inheritedListeners; // Listener fds handed over by the master process (if any)
+    std::vector<ListenerHandler> _listenerHandlers; // Poller tags for the listeners (never resized after init)
+    uint32_t _listenEvents;                         // Interest the listeners are registered with
+
+    // Client slab: preallocated once (worker_connections slots) so the Client*
+    // registered with the poller stays valid for the server's lifetime.
+    std::vector<Client> _clientSlab;
+    std::vector<Client*> _freeClients;     // Slots ready for new connections
+    std::vector<Client*> _releasedClients; // Slots freed during the current event batch
+    size_t _activeClients;
+    size_t _closingClients;               // Closed slots the poller still owes completions
+    std::unique_ptr<Poller> _poller;      // Event backend (epoll or io_uring, see event_backend)
+    bool _completionIo;                   // The poller accepts, receives and sends (io_uring)
+    PollerEvent _events[MAX_EVENTS];      // Buffer for Poller::wait events
+
+    // Accept batching counters (see handleNewConnection)
+    unsigned long _acceptWakeups;     // Listener EPOLLIN events handled
+    unsigned long _acceptedTotal;     // Connections accepted across all wake-ups
+    unsigned long _acceptBatchMax;    // Largest number accepted in a single wake-up
+
+    // Overload protection: worker_connections / worker_memory_limit
+    size_t _bufferedBytes;            // Sum of Client::getBufferedBytes() as last accounted
+    bool _acceptPaused;               // Listeners removed from the poller until load drops
+    unsigned long _shedTotal;         // Connections answered with the static 503
+
+    // Input buffers, lent to connections only while they have unprocessed data
+    BufferPool _bufferPool;
+
+    // open_file_cache: resolved static paths with their open descriptors
+    OpenFileCache _fileCache;
+    // Serialized responses for small hot files, sent by reference
+    ResponseCache _responseCache;
+    // Serialized gzip responses compressed on the fly (gzip on)
+    ResponseCache _gzipCache;
+    // Error responses prebuilt at startup (error_page files included)
+    ErrorPages _errorPages;
+
+    // Timeouts: one TimerWheel node per client, the wait timeout comes from the next expiry
+    TimerWheel _timers;
+    std::vector<TimerNode*> _expiredTimers; // Scratch buffer reused by expireTimers()
+    uint64_t _nowMs;                        // Monotonic time of the current loop iteration
+
+    // Graceful shutdown / binary upgrade
+    bool _draining;                             // Listeners closed, waiting for clients to finish
+    pid_t _newBinary;                           // Binary started by SIGUSR2 until it exits (-1 if none)
+    static volatile sig_atomic_t _drainRequested;
+    static volatile sig_atomic_t _upgradeRequested;
+    static volatile sig_atomic_t _childExited;
+    static void signalHandler(int signum);
+    std::atomic<bool> _drainPending; // Set by requestDrain()
+    int _wakeupFd;                   // eventfd requestDrain() writes to, so Poller::wait returns
+    EventHandler _wakeupHandler;
 
     // Private methods for handling server logic
     void setupListeningSockets(); // Create sockets based on config
-    void createEpoll();           // Initialize epoll
-    void addSocketToEpoll(int fd, uint32_t events);
-    void modifySocketInEpoll(int fd, uint32_t events); // Added helper
-    void removeSocketFromEpoll(int fd);
-    void handleEpollEvents(int numEvents); // Process events from epoll_wait
-    void handleNewConnection(int listenerFd); // Accept new client
-    void handleClientRead(int clientFd);  // Renamed from handleClientData
-    void handleClientWrite(int clientFd); // Added for sending response
-    void handleClientError(int clientFd); // Added for EPOLLERR/HUP
-    void handleClientDisconnection(int clientFd, bool isError = false); // Updated signature
+    void createPoller();           // Initialize the configured event backend
+    void addSocketToPoller(int fd, uint32_t events, EventHandler* handler);
+    void modifyClientInPoller(Client& client, uint32_t events); // Added helper
+    void removeSocketFromPoller(int fd);
+    void handlePollerEvents(int numEvents); // Process events from Poller::wait
+    void handleNewConnection(const ListenerHandler& listener); // Accept new client
+    void watchListener(size_t index);   // Start accepting on a listener (poller or multishot accept)
+    void unwatchListener(size_t index); // Stop accepting on it
+    bool admitConnection(int clientFd, const struct sockaddr_in& addr, size_t serverIndex); // Slot + poller for an accepted fd
+    Client* allocateClient(int clientFd, const struct sockaddr_in& addr, size_t serverIndex); // Take a free slab slot
+    void recycleReleasedClients(); // Return slots freed in this batch to the free list
+    bool isOverloaded() const;     // No free slot, or buffered bytes over worker_memory_limit
+    void pauseAccept();            // Stop accepting on the listeners (unwatchListener)
+    void updateAcceptState();      // Resume once load is back under the low-water mark (completion I/O: also pause)
+    void shedConnection(int clientFd); // Write the prebuilt 503 and close
+    void accountMemory(Client& client); // Fold the client's buffer growth into _bufferedBytes
+    void logBufferPool() const;         // Occupancy of _bufferPool
+    void handleClientRead(Client& client);  // Renamed from handleClientData
+    void handleClientWrite(Client& client); // Added for sending response
+    void handleClientError(Client& client); // Added for EPOLLERR/HUP
+    void finishClientEvent(Client& client); // Close, or re-arm timers and accounting, after the client's I/O
+    // Completion-based I/O (Poller::supportsCompletions)
+    void handleCompletion(const PollerEvent& event);
+    void handleAcceptCompletion(const ListenerHandler& listener, const PollerEvent& event);
+    void handleClientReceived(Client& client, const PollerEvent& event);
+    void handleClientSent(Client& client, const PollerEvent& event);
+    bool startReceiving(Client& client);  // Arm the client's multishot recv
+    void submitClientSend(Client& client); // Keep one send (or file read) in flight while output is queued
+    void releaseClientSlot(Client& client); // Reset the slot; it is reused after the current batch
+    void handleClientDisconnection(Client& client, bool isError = false); // Updated signature
+    size_t serveBufferedRequests(Client& client); // Queue responses for pipelined requests already read
+    void updateWriteInterest(Client& client);     // Register EPOLLOUT only while output is pending
+    void handleSignals();                         // Act on flags set by signalHandler
+    void beginDrain();                            // Stop accepting and close idle connections
+    bool isIdle(const Client& client) const;      // Nothing buffered, nothing queued
+
+    // Timeouts
+    static uint64_t monotonicMs();
+    void refreshClientTimer(Client& client); // Arm the timer matching the client's current phase
+    void expireTimers();                     // Close clients whose timer fired
 
     // Request/Response Processing
     void processRequest(Client& client); // New method to handle logic
-    Response generateResponse(const Request& request, const Config& config); // New method
-    Response generateErrorResponse(int statusCode, const Config& config); // New method
+    Response generateResponse(const Request& request, const Config& config, size_t server); // server: Client::getServerIndex
+    Response generateErrorResponse(int statusCode, const Config& config, size_t server); // Prebuilt error_page for that server block
+    FileLookup resolveStaticFile(const std::string& path); // stat/index, on an open_file_cache miss
+    const FileLookup* lookupStaticFile(const std::string& path, FileLookup& scratch); // open_file_cache first
+    bool openStaticFile(const std::string& path, FileLookup& lookup); // open() a fresh resolution and cache it
+    Response fileResponse(const FileLookup& source, const std::string& contentType,
+                          const std::string& requestPath, const char* encoding, bool vary, size_t server);
+    Response gzipResponse(const FileLookup& lookup, const std::string& requestPath, size_t server);
+    bool isNotModified(const Request& request, const FileLookup& lookup) const; // If-None-Match / If-Modified-Since
 
     // Prevent copying
     Server(const Server&);
@@ -11,7 +11,12 @@ public:
     ~Socket();
 
     // Initialize the listening socket - now takes host
-    bool init(const std::string& host = "127.0.0.1"); // Add host parameter, default localhost
+    // reusePort sets SO_REUSEPORT so several event loops can each bind their own listener
+    // on the same host:port and let the kernel balance new connections between them.
+    bool init(const std::string& host = "127.0.0.1", bool reusePort = false); // Add host parameter, default localhost
+    // Take ownership of an fd that is already bound and listening (e.g., inherited
+    // from the master process); fills in port/address from getsockname().
+    bool adopt(int fd);
     // Close the socket
     void closeSocket();
     // Get the file descriptor
@@ -0,0 +1,57 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vector>
+#include <stdint.h> // For uint64_t
+#include <cstddef>  // For size_t, NULL
+
+#define TIMER_TICK_MS 100    // Wheel resolution
+#define TIMER_WHEEL_BITS 6   // 64 slots per level
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4 // 64^4 ticks of 100ms: ~19 days of range
+
+// Intrusive timer entry, embedded in the object it times out (e.g., Client).
+// Arm/cancel only relink pointers, so they never allocate.
+struct TimerNode {
+    TimerNode* prev;
+    TimerNode* next;
+    uint64_t expires; // Absolute tick
+    void* owner;      // Object to act on when the timer fires
+
+    TimerNode() : prev(NULL), next(NULL), expires(0), owner(NULL) {}
+    bool isArmed() const { return prev != NULL; }
+};
+
+// Hierarchical timing wheel (as in the Linux kernel timers):
+// level 0 holds timers due within 64 ticks, each further level covers 64x the
+// range of the previous one and is cascaded down when the lower level wraps.
+// arm/cancel are O(1); advancing only touches the slots whose time has come,
+// so expiring connections never requires scanning every client.
+class TimerWheel {
+public:
+    TimerWheel();
+
+    // (Re)arm node to fire timeoutMs after nowMs
+    void arm(TimerNode* node, uint64_t timeoutMs, uint64_t nowMs);
+    void cancel(TimerNode* node);
+    // Move the wheel forward to nowMs, appending every expired node to expired
+    void advance(uint64_t nowMs, std::vector<TimerNode*>& expired);
+    // Milliseconds until the wheel next has work (timer due or cascade), -1 if empty
+    int nextTimeoutMs(uint64_t nowMs) const;
+    size_t size() const;
+
+private:
+    TimerNode _slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE]; // List heads (sentinels)
+    uint64_t _currentTick;
+    bool _started;
+    size_t _count;
+
+    void insert(TimerNode* node);
+    void cascade(int level);
+
+    // Prevent copying (sentinels point at themselves)
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+};
+
+#endif // TIMERWHEEL_HPP
@@ -0,0 +1,44 @@
+#ifndef UPGRADE_HPP
+#define UPGRADE_HPP
+
+#include <string>
+#include <vector>
+#include <sys/types.h> // For pid_t
+
+// Environment variable carrying the listening fds to the new binary ("fd;fd;...")
+#define UPGRADE_LISTEN_FDS_ENV "WEBSERV_LISTEN_FDS"
+
+// Zero-downtime binary upgrade (SIGUSR2):
+// the running process forks and execs the binary at its original argv[0] with its
+// listening fds left open and listed in UPGRADE_LISTEN_FDS_ENV. The new process
+// adopts those fds instead of binding, and once it is serving it sends SIGQUIT to
+// the old process, which stops accepting and drains its connections before exiting.
+class Upgrade {
+public:
+    // Remember the command line so the (replaced) binary can be re-executed
+    static void saveCommandLine(char* argv[]);
+
+    // Read UPGRADE_LISTEN_FDS_ENV (if set) into the pool of inherited listeners
+    static void loadInheritedListeners();
+    // Take the inherited fd listening on host:port out of the pool (-1 if none)
+    static int claimListener(const std::string& host, int port);
+    // Close inherited fds the new config no longer listens on
+    static void closeUnclaimedListeners();
+    // True if this process was started by an upgrade
+    static bool isUpgradeChild();
+    // Tell the process that exec'd us to drain and exit (no-op unless isUpgradeChild())
+    static void retireParent();
+
+    // Fork + exec the binary with listenerFds inherited; returns the child pid or -1
+    static pid_t spawnNewBinary(const std::vector<int>& listenerFds);
+
+private:
+    static std::vector<std::string> _argv;
+    static std::vector<int> _inherited;
+    static bool _upgradeChild;
+    static pid_t _upgradePid; // Process that loaded the fds (not its forked workers)
+
+    Upgrade();
+};
+
+#endif // UPGRADE_HPP
@@ -0,0 +1,38 @@
+#include "BufferPool.hpp"
+
+BufferPool::BufferPool() : _overflow(IO_OVERFLOW_SIZE), _inUse(0), _peakInUse(0), _allocations(0) {
+    _free.reserve(IO_BUFFER_POOL_MAX_FREE);
+}
+
+void BufferPool::acquire(std::string& buffer) {
+    if (!_free.empty()) {
+        buffer.swap(_free.back());
+        _free.pop_back();
+    } else {
+        buffer.reserve(IO_BUFFER_SIZE);
+        ++_allocations;
+    }
+    if (++_inUse > _peakInUse) {
+        _peakInUse = _inUse;
+    }
+}
+
+void BufferPool::release(std::string& buffer) {
+    if (_inUse > 0) {
+        --_inUse;
+    }
+    buffer.clear();
+    if (buffer.capacity() == IO_BUFFER_SIZE && _free.size() < IO_BUFFER_POOL_MAX_FREE) {
+        _free.push_back(std::string());
+        _free.back().swap(buffer);
+    } else {
+        std::string().swap(buffer);
+    }
+}
+
+char* BufferPool::overflow() { return &_overflow[0]; }
+size_t BufferPool::overflowSize() const { return _overflow.size(); }
+size_t BufferPool::getInUse() const { return _inUse; }
+size_t BufferPool::getFree() const { return _free.size(); }
+size_t BufferPool::getPeakInUse() const { return _peakInUse; }
+unsigned long BufferPool::getAllocations() const { return _allocations; }
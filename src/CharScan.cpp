@@ -0,0 +1,305 @@
+#include "CharScan.hpp"
+#include <cstring> // For memchr, memcpy, strcmp
+#include <stdint.h> // For uint64_t
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHARSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." /
+//         "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA   (RFC 9110 section 5.6.2)
+// All 256 byte values, so a lookup needs no range check (the upper half is zero)
+static const unsigned char TOKEN_CHARS[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 0
+};
+
+bool CharScan::isTokenChar(unsigned char c) {
+    return TOKEN_CHARS[c] != 0;
+}
+
+// --- Scalar fallback ---
+// Byte loops: also the tails of the vector kernels (under 16 bytes, too short for
+// anything wider). The scalar implementation checks long runs (field values,
+// targets) 8 bytes at a time first: a word that may hold a stop byte is resolved
+// byte by byte.
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+static inline uint64_t loadWord(const char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word)); // Unaligned load, one instruction
+    return word;
+}
+
+// Nonzero if some byte of word is below limit (limit <= 0x80); never misses one
+static inline uint64_t swarHasLess(uint64_t word, unsigned char limit) {
+    return (word - SWAR_ONES * limit) & ~word & SWAR_HIGHS;
+}
+
+// Nonzero if some byte of word equals c; never misses one
+static inline uint64_t swarHasByte(uint64_t word, unsigned char c) {
+    return swarHasLess(word ^ (SWAR_ONES * c), 1);
+}
+
+static inline bool isFieldValueStop(unsigned char c) {
+    return (c < 0x20 && c != '\t') || c == 0x7f;
+}
+
+static inline bool isTargetStop(unsigned char c) {
+    return c <= 0x20 || c == 0x7f;
+}
+
+static const char* findLineEndScalar(const char* p, const char* end) {
+    const void* hit = std::memchr(p, '\n', end - p); // libc's memchr is already word/vector-wide
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+static const char* skipTokenCharsScalar(const char* p, const char* end) {
+    while (p < end && TOKEN_CHARS[static_cast<unsigned char>(*p)]) ++p;
+    return p;
+}
+
+static const char* skipFieldValueCharsBytes(const char* p, const char* end) {
+    while (p < end && !isFieldValueStop(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+static const char* skipTargetCharsBytes(const char* p, const char* end) {
+    while (p < end && !isTargetStop(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+static const char* skipFieldValueCharsScalar(const char* p, const char* end) {
+    for (; end - p >= 8; p += 8) {
+        uint64_t word = loadWord(p);
+        if (swarHasLess(word, 0x20) | swarHasByte(word, 0x7f)) {
+            const char* stop = skipFieldValueCharsBytes(p, p + 8);
+            if (stop != p + 8) return stop; // Otherwise only HTABs
+        }
+    }
+    return skipFieldValueCharsBytes(p, end);
+}
+
+static const char* skipTargetCharsScalar(const char* p, const char* end) {
+    for (; end - p >= 8; p += 8) {
+        uint64_t word = loadWord(p);
+        if (swarHasLess(word, 0x21) | swarHasByte(word, 0x7f)) {
+            return skipTargetCharsBytes(p, p + 8); // Flagged words hold a stop: the tests only over-report above a real one
+        }
+    }
+    return skipTargetCharsBytes(p, end);
+}
+
+#ifdef CHARSCAN_X86
+
+// Token test for 16/32 bytes at once: the low nibble selects a byte of
+// TOKEN_BY_LOW_NIBBLE whose bit h is set if (h << 4 | low) is a tchar; the high
+// nibble selects that bit (0 for h >= 8, so non-ASCII bytes never match).
+static const char TOKEN_BY_LOW_NIBBLE[16] = {
+    (char)0xe8, (char)0xfc, (char)0xf8, (char)0xfc, (char)0xfc, (char)0xfc, (char)0xfc, (char)0xfc,
+    (char)0xf8, (char)0xf8, (char)0xf4, (char)0x54, (char)0xd0, (char)0x54, (char)0xf4, (char)0x70
+};
+static const char BIT_BY_HIGH_NIBBLE[16] = {
+    1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// --- SSE4.2: 16 bytes per step ---
+// Always inlined: the AVX2 kernels reuse them for their tails, and inlined there
+// they are VEX-encoded. A call into legacy-SSE code with the upper YMM halves
+// dirty costs more than the whole scan (SSE/AVX transition penalty).
+#define SSE42_KERNEL __attribute__((target("sse4.2"), always_inline)) inline
+
+SSE42_KERNEL
+static const char* findLineEndSse42(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findLineEndScalar(p, end);
+}
+
+SSE42_KERNEL
+static const char* skipTokenCharsSse42(const char* p, const char* end) {
+    const __m128i lowTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TOKEN_BY_LOW_NIBBLE));
+    const __m128i highTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(BIT_BY_HIGH_NIBBLE));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i low = _mm_shuffle_epi8(lowTable, _mm_and_si128(chunk, nibble));
+        __m128i high = _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+        __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+        int mask = _mm_movemask_epi8(invalid);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return skipTokenCharsScalar(p, end);
+}
+
+// PCMPESTRI in range mode: index of the first byte inside any of the given ranges
+SSE42_KERNEL
+static const char* findInRangesSse42(const char* p, const char* end, const char* ranges, int rangesLength,
+                                     const char* (*tail)(const char*, const char*)) {
+    const __m128i set = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int index = _mm_cmpestri(set, rangesLength, chunk, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (index != 16) return p + index;
+    }
+    return tail(p, end);
+}
+
+// 16-byte buffers so the loads above stay in bounds
+static const char FIELD_VALUE_STOP[16] = "\x00\x08\x0a\x1f\x7f\x7f"; // CTLs except HTAB, DEL
+static const char TARGET_STOP[16] = "\x00\x20\x7f\x7f";              // CTLs, SP, DEL
+
+SSE42_KERNEL
+static const char* skipFieldValueCharsSse42(const char* p, const char* end) {
+    return findInRangesSse42(p, end, FIELD_VALUE_STOP, 6, skipFieldValueCharsBytes);
+}
+
+SSE42_KERNEL
+static const char* skipTargetCharsSse42(const char* p, const char* end) {
+    return findInRangesSse42(p, end, TARGET_STOP, 4, skipTargetCharsBytes);
+}
+
+// --- AVX2: 32 bytes per step ---
+
+__attribute__((target("avx2")))
+static const char* findLineEndAvx2(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findLineEndSse42(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skipTokenCharsAvx2(const char* p, const char* end) {
+    // VPSHUFB looks up within each 128-bit lane, so both lanes carry the table
+    const __m128i low128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TOKEN_BY_LOW_NIBBLE));
+    const __m128i high128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(BIT_BY_HIGH_NIBBLE));
+    const __m256i lowTable = _mm256_broadcastsi128_si256(low128);
+    const __m256i highTable = _mm256_broadcastsi128_si256(high128);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(chunk, nibble));
+        __m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+        __m256i invalid = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(invalid));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return skipTokenCharsSse42(p, end);
+}
+
+// Unsigned "c <= limit" for every byte: min(c, limit) == c
+__attribute__((target("avx2")))
+static inline __m256i bytesAtMost(__m256i chunk, char limit) {
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, _mm256_set1_epi8(limit)), chunk);
+}
+
+__attribute__((target("avx2")))
+static const char* skipFieldValueCharsAvx2(const char* p, const char* end) {
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i control = _mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), bytesAtMost(chunk, 0x1f));
+        __m256i stop = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, del));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(stop));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return skipFieldValueCharsSse42(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skipTargetCharsAvx2(const char* p, const char* end) {
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i stop = _mm256_or_si256(bytesAtMost(chunk, 0x20), _mm256_cmpeq_epi8(chunk, del));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(stop));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return skipTargetCharsSse42(p, end);
+}
+
+#endif // CHARSCAN_X86
+
+// --- Runtime dispatch, resolved once during static initialization ---
+
+typedef const char* (*ScanFunction)(const char*, const char*);
+
+struct ScanImplementation {
+    const char* name;
+    ScanFunction lineEnd;
+    ScanFunction token;
+    ScanFunction fieldValue;
+    ScanFunction target;
+};
+
+// Fastest first; an entry is usable if the CPU supports its feature (NULL: always)
+static const struct {
+    const char* feature;
+    ScanImplementation impl;
+} IMPLEMENTATIONS[] = {
+#ifdef CHARSCAN_X86
+    { "avx2", { "avx2", findLineEndAvx2, skipTokenCharsAvx2, skipFieldValueCharsAvx2, skipTargetCharsAvx2 } },
+    { "sse4.2", { "sse4.2", findLineEndSse42, skipTokenCharsSse42, skipFieldValueCharsSse42, skipTargetCharsSse42 } },
+#endif
+    { NULL, { "scalar", findLineEndScalar, skipTokenCharsScalar, skipFieldValueCharsScalar, skipTargetCharsScalar } },
+};
+#define IMPLEMENTATION_COUNT (sizeof(IMPLEMENTATIONS) / sizeof(IMPLEMENTATIONS[0]))
+
+static bool cpuSupports(const char* feature) {
+    if (!feature) {
+        return true;
+    }
+#ifdef CHARSCAN_X86
+    __builtin_cpu_init(); // Required before __builtin_cpu_supports in a static initializer
+    return std::strcmp(feature, "avx2") == 0 ? __builtin_cpu_supports("avx2")
+                                             : __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+static ScanImplementation selectImplementation() {
+    size_t i = 0;
+    while (!cpuSupports(IMPLEMENTATIONS[i].feature)) {
+        ++i; // The scalar entry always matches
+    }
+    return IMPLEMENTATIONS[i].impl;
+}
+
+// Written once during static initialization; select() only rewrites it before any parsing starts
+static ScanImplementation g_scan = selectImplementation();
+
+const char* CharScan::findLineEnd(const char* p, const char* end) { return g_scan.lineEnd(p, end); }
+const char* CharScan::skipTokenChars(const char* p, const char* end) { return g_scan.token(p, end); }
+const char* CharScan::skipFieldValueChars(const char* p, const char* end) { return g_scan.fieldValue(p, end); }
+const char* CharScan::skipTargetChars(const char* p, const char* end) { return g_scan.target(p, end); }
+const char* CharScan::implementation() { return g_scan.name; }
+
+bool CharScan::select(const char* name) {
+    for (size_t i = 0; i < IMPLEMENTATION_COUNT; ++i) {
+        if (std::strcmp(IMPLEMENTATIONS[i].impl.name, name) == 0 && cpuSupports(IMPLEMENTATIONS[i].feature)) {
+            g_scan = IMPLEMENTATIONS[i].impl;
+            return true;
+        }
+    }
+    return false;
+}
@@ -6,16 +6,49 @@
 #include <cstring> // for strerror
 #include <cerrno> // for errno
 #include <utility> // For std::move
+#include <sys/uio.h> // For struct iovec, readv
+#include <sys/sendfile.h> // For sendfile
+#include <algorithm> // For std::min
 
-// #define READ_BUFFER_SIZE 4096 // <-- Remove definition from here
+
+Client::Client() :
+    EventHandler(CLIENT),
+    _clientFd(-1),
+    _state(AWAITING_REQUEST),
+    _bytesSent(0),
+    _queuedResponses(0),
+    _keepAlive(true),
+    _writeInterest(false),
+    _timeoutKind(TIMEOUT_NONE),
+    _requestCount(0),
+    _accountedBytes(0),
+    _hasInputBuffer(false),
+    _serverIndex(0),
+    _sending(false),
+    _pendingOperations(0)
+{
+    std::memset(&_sendMsg, 0, sizeof(_sendMsg));
+    std::memset(&_clientAddr, 0, sizeof(_clientAddr));
+}
 
 Client::Client(int fd, const struct sockaddr_in& addr) :
+    EventHandler(CLIENT),
     _clientFd(fd),
     _clientAddr(addr),
     _state(AWAITING_REQUEST),
     _bytesSent(0),
-    _requestParsed(false)
+    _queuedResponses(0),
+    _keepAlive(true),
+    _writeInterest(false),
+    _timeoutKind(TIMEOUT_NONE),
+    _requestCount(0),
+    _accountedBytes(0),
+    _hasInputBuffer(false),
+    _serverIndex(0),
+    _sending(false),
+    _pendingOperations(0)
 {
+    std::memset(&_sendMsg, 0, sizeof(_sendMsg));
     // std::cout << "Client created for fd=" << _clientFd << std::endl;
 }
 
@@ -28,13 +61,14 @@ Client::~Client() {
 }
 
 void Client::clear() {
-     _requestBuffer.clear();
-     _responseBuffer.clear();
-     _request = Request(); // Reset request object
-     _requestParsed = false;
-     _bytesSent = 0;
-     _state = AWAITING_REQUEST;
-     // Keep _clientFd and _clientAddr
+     // Drop only the bytes the finished request used; anything after it is the
+     // start of the next request and must survive the reset.
+     size_t consumed = isRequestValid() ? _request.getRequestLength() : _requestBuffer.length();
+     _requestBuffer.erase(0, consumed);
+     _request.reset(); // Reset parser state, keeping the header array's allocation
+     _requestBody.reset(); // Closes a spilled body's temp file
+     _state = _responseQueue.empty() ? AWAITING_REQUEST : SENDING_RESPONSE;
+     // Keep _clientFd, _clientAddr, queued responses, the timer and the request count
 }
 
 
@@ -60,34 +94,61 @@ const std::string& Client::getRawRequest() const {
 }
 
 bool Client::isParsed() const {
-    return _requestParsed;
+    return _request.getState() == Request::Complete || _request.getState() == Request::Error;
+}
+
+bool Client::isRequestValid() const {
+    return _request.getState() == Request::Complete;
+}
+
+bool Client::isKeepAlive() const {
+    return _keepAlive;
+}
+
+void Client::setKeepAlive(bool keepAlive) {
+    _keepAlive = keepAlive;
 }
 
 // Reads data from socket into _requestBuffer
 // Returns: bytes read, 0 on EOF, -1 on error, -2 on EAGAIN/EWOULDBLOCK
-ssize_t Client::receiveData() {
-    std::vector<char> buffer(READ_BUFFER_SIZE);
-    ssize_t bytes_read = recv(_clientFd, buffer.data(), buffer.size(), 0);
-
-    if (bytes_read > 0) {
-        _requestBuffer.append(buffer.data(), bytes_read);
-        // Check if headers are complete after receiving new data
-        if (isRequestReady() && _state == AWAITING_REQUEST) {
-            _state = REQUEST_RECEIVED;
-            std::cout << "Client fd=" << _clientFd << ": Request received." << std::endl;
-        }
-    } else if (bytes_read == 0) {
-        // Connection closed by peer
+// Reads straight into the spare capacity of the (pooled) input buffer; whatever
+// doesn't fit lands in the pool's shared overflow chunk in the same readv() and
+// is appended, so a large body takes one syscall per 80 KB instead of per 4 KB.
+ssize_t Client::receiveData(BufferPool& pool) {
+    if (!_hasInputBuffer) {
+        pool.acquire(_requestBuffer);
+        _hasInputBuffer = true;
+    }
+    size_t used = _requestBuffer.size();
+    size_t spare = _requestBuffer.capacity() - used;
+    _requestBuffer.resize(used + spare); // Within capacity: no allocation
+
+    struct iovec iov[2];
+    iov[0].iov_base = &_requestBuffer[0] + used;
+    iov[0].iov_len = spare;
+    iov[1].iov_base = pool.overflow();
+    iov[1].iov_len = pool.overflowSize();
+    ssize_t bytes_read = readv(_clientFd, spare > 0 ? iov : iov + 1, spare > 0 ? 2 : 1);
+
+    size_t received = bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0;
+    _requestBuffer.resize(used + std::min(received, spare));
+    if (received > spare) {
+        _requestBuffer.append(pool.overflow(), received - spare);
+    }
+
+    // Completeness is checked by the server once the socket is drained,
+    // so several pipelined requests can be served from one wake-up.
+    if (bytes_read == 0) {
+        // Connection closed by peer (requests already buffered may still be answered)
         std::cout << "Client fd=" << _clientFd << ": Connection closed by peer." << std::endl;
-        _state = RESPONSE_SENT; // Treat as finished
         return 0; // Indicate EOF
-    } else { // bytes_read < 0
+    } else if (bytes_read < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
              // No more data available right now (non-blocking)
             return -2; // Indicate non-blocking would block
         } else {
             // Actual error
-            perror("recv failed");
+            perror("readv failed");
             _state = RESPONSE_SENT; // Treat as finished/error
             return -1; // Indicate error
         }
@@ -95,120 +156,400 @@ ssize_t Client::receiveData() {
     return bytes_read;
 }
 
+void Client::returnBuffers(BufferPool& pool) {
+    if (_hasInputBuffer) {
+        pool.release(_requestBuffer);
+        _hasInputBuffer = false;
+    }
+}
+
 // Check if the request headers seem complete (contains "\r\n\r\n")
-bool Client::isRequestReady() const {
-    return _requestBuffer.find("\r\n\r\n") != std::string::npos;
+bool Client::hasCompleteHeaders() const {
+    return _request.hasCompleteHeaders();
+}
+
+// Feed the parser whatever arrived since the last call (it resumes, never rescans)
+bool Client::isRequestReady() {
+    _request.setBodyConsumer(&_requestBody); // Re-pointed every time: slab slots are move-assigned
+    Request::ParseState state = _request.parse(_requestBuffer);
+    return state == Request::Complete || state == Request::Error;
+}
+
+void Client::setBodyLimits(size_t maxBodySize, size_t bufferSize) {
+    _request.setMaxBodySize(maxBodySize); // Survives Request::reset() between requests
+    _requestBody.setBufferSize(bufferSize);
+}
+
+void Client::setServerIndex(size_t index) {
+    _serverIndex = index;
+}
+
+size_t Client::getServerIndex() const {
+    return _serverIndex;
+}
+
+RequestBody& Client::getRequestBody() {
+    return _requestBody;
 }
 
-// Get the parsed request object
 Request& Client::getRequest() {
-    if (!_requestParsed && isRequestReady()) {
-        try {
-            // Call the actual parsing function
-            if (_request.parse(_requestBuffer)) {
-                 _requestParsed = true;
-                 std::cout << "Client fd=" << _clientFd << ": Request parsed successfully." << std::endl;
-            } else {
-                 // Parsing failed (e.g., bad syntax, incomplete body needed)
-                 // If parse returns false because more body data is needed, keep _requestParsed = false
-                 // If parse returns false due to syntax error, maybe throw or set error state?
-                 // For now, assume false means syntax error or unrecoverable issue.
-                 std::cerr << "Client fd=" << _clientFd << ": Request::parse returned false." << std::endl;
-                  _requestParsed = true; // Prevent retry loop on syntax error
-                  _state = GENERATING_RESPONSE; // Generate 400 Bad Request
-                  // Potentially clear the request object or set error flag in it?
-            }
-        } catch (const std::exception& e) {
-             std::cerr << "Client fd=" << _clientFd << ": Request parsing exception: " << e.what() << std::endl;
-             _requestParsed = true; // Mark as parsed even on error to avoid loop
-             _state = GENERATING_RESPONSE; // Move to generate error response
+    _request.setBodyConsumer(&_requestBody);
+    _request.parse(_requestBuffer); // No-op once finished; re-points the request at our buffer
+    return _request;
+}
+
+
+// Queue the response behind any responses still waiting to be sent, as segments:
+// the serialized head, then the body moved out of the response (or a file range).
+// Nothing is concatenated; sendData() gathers the segments with one sendmsg().
+void Client::queueResponse(Response& response) {
+    const CachedResponse& cached = response.getCached();
+    if (cached.blob) {
+        // Cached: reference the shared blob around our own Connection line
+        queueBlob(cached.blob, 0, cached.headEnd);
+        _responseQueue.push_back(OutputSegment());
+        OutputSegment& connection = _responseQueue.back();
+        connection.data = "Connection: " + response.getHeader(HEADER_CONNECTION) + "\r\n\r\n";
+        size_t bodyStart = cached.headEnd + 2; // After the blank line
+        if (bodyStart < cached.blob->size()) {
+            queueBlob(cached.blob, bodyStart, cached.blob->size() - bodyStart);
+        }
+    } else {
+        _responseQueue.push_back(OutputSegment());
+        OutputSegment& head = _responseQueue.back();
+        response.appendHead(head.data); // Written straight into the segment's buffer
+        std::string body = response.takeBody();
+        if (!body.empty()) {
+            _responseQueue.push_back(OutputSegment());
+            OutputSegment& bodySegment = _responseQueue.back();
+            bodySegment.data.swap(body);
         }
     }
-    return _request;
+    const std::vector<Response::BodyPart>& parts = response.getBodyParts();
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i].file ? parts[i].fileLength == 0 : parts[i].text.empty()) {
+            continue;
+        }
+        _responseQueue.push_back(OutputSegment());
+        OutputSegment& part = _responseQueue.back();
+        if (parts[i].file) {
+            part.file = parts[i].file;
+            part.fileOffset = parts[i].fileOffset;
+            part.fileRemaining = parts[i].fileLength;
+        } else {
+            part.data = parts[i].text;
+        }
+    }
+    _responseQueue.back().endsResponse = true;
+    ++_queuedResponses;
+    setState(SENDING_RESPONSE);
 }
 
+void Client::queueBlob(const std::shared_ptr<const std::string>& blob, size_t offset, size_t length) {
+    _responseQueue.push_back(OutputSegment());
+    OutputSegment& segment = _responseQueue.back();
+    segment.blob = blob;
+    segment.blobOffset = offset;
+    segment.blobLength = length;
+}
 
-// Store the generated response string
-void Client::setResponse(const Response& response) {
-    // Use Response::toString() to generate the full response string
-    _responseBuffer = response.toString();
+// Pop the front segment once it is fully sent
+void Client::popSentSegment() {
+    if (_responseQueue.front().endsResponse) {
+        --_queuedResponses;
+    }
+    _responseQueue.pop_front();
     _bytesSent = 0;
-    setState(SENDING_RESPONSE);
-    std::cout << "Client fd=" << _clientFd << ": Response set (" << _responseBuffer.length() << " bytes)." << std::endl;
-     // Optional: Log response headers for debugging
-     // size_t headers_end = _responseBuffer.find("\r\n\r\n");
-     // if (headers_end != std::string::npos) {
-     //      std::cout << "--- Response Headers fd=" << _clientFd << " ---\n"
-     //                << _responseBuffer.substr(0, headers_end) << "\n------------------------" << std::endl;
-     // }
 }
 
-// Send data from _responseBuffer
+// In-memory segments from the front of the queue, up to the first file range, as
+// iovecs (the first one starting after the bytes already sent). MSG_MORE is added
+// when a file range follows, so the headers share packets with its first bytes.
+size_t Client::gatherSegments(struct iovec* iov, int& flags) const {
+    size_t segments = 0;
+    for (std::deque<OutputSegment>::const_iterator it = _responseQueue.begin();
+         it != _responseQueue.end() && segments < MAX_IOV_SEGMENTS; ++it, ++segments) {
+        if (it->file) {
+            flags |= MSG_MORE; // File data follows right away
+            break;
+        }
+        size_t offset = (segments == 0) ? _bytesSent : 0;
+        iov[segments].iov_base = const_cast<char*>(it->bytes()) + offset;
+        iov[segments].iov_len = it->length() - offset;
+    }
+    return segments;
+}
+
+void Client::advanceSent(size_t bytes) {
+    while (bytes > 0) {
+        size_t left = _responseQueue.front().length() - _bytesSent;
+        if (bytes < left) {
+            _bytesSent += bytes;
+            break;
+        }
+        bytes -= left;
+        popSentSegment();
+    }
+}
+
+// Send queued output until the queue is empty or the socket is full. Runs of
+// in-memory segments are gathered into one sendmsg() (writev with MSG_NOSIGNAL,
+// so a vanished peer can't SIGPIPE us); file ranges go out with sendfile().
 // Returns: bytes sent, 0 if nothing to send, -1 on error, -2 on EAGAIN/EWOULDBLOCK
 ssize_t Client::sendData() {
-    if (_responseBuffer.empty() || _bytesSent >= _responseBuffer.length()) {
+    if (_responseQueue.empty()) {
         return 0; // Nothing (more) to send
     }
 
-    size_t bytes_to_send = _responseBuffer.length() - _bytesSent;
-    const char* buffer_ptr = _responseBuffer.c_str() + _bytesSent;
-
-    ssize_t bytes_written = send(_clientFd, buffer_ptr, bytes_to_send, 0); // Consider MSG_NOSIGNAL
-
-    if (bytes_written > 0) {
-        _bytesSent += bytes_written;
-        // std::cout << "Client fd=" << _clientFd << ": Sent " << bytes_written << " bytes (" << _bytesSent << "/" << _responseBuffer.length() << ")" << std::endl;
-        if (isResponseFullySent()) {
-            std::cout << "Client fd=" << _clientFd << ": Full response sent." << std::endl;
-            setState(RESPONSE_SENT);
-            // If keep-alive: clear(); and set state AWAITING_REQUEST
-            // If not keep-alive: leave state as RESPONSE_SENT for server to close
+    size_t totalSent = 0;
+    while (!_responseQueue.empty()) {
+        ssize_t bytes_written;
+        const char* call;
+        OutputSegment& front = _responseQueue.front();
+        if (front.file) {
+            call = "sendfile";
+            bytes_written = sendfile(_clientFd, front.file->fd, &front.fileOffset, front.fileRemaining);
+            if (bytes_written == 0) {
+                // The file shrank after the headers announced its length: the response can't be completed
+                std::cerr << "Client fd=" << _clientFd << ": file ended early, closing." << std::endl;
+                setState(RESPONSE_SENT);
+                return -1;
+            }
+            if (bytes_written > 0) {
+                front.fileRemaining -= bytes_written;
+                if (front.fileRemaining == 0) {
+                    popSentSegment();
+                }
+            }
+        } else {
+            call = "sendmsg";
+            struct iovec iov[MAX_IOV_SEGMENTS];
+            int flags = MSG_NOSIGNAL;
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = gatherSegments(iov, flags);
+            bytes_written = sendmsg(_clientFd, &msg, flags);
+            if (bytes_written > 0) {
+                advanceSent(static_cast<size_t>(bytes_written));
+            }
         }
-        return bytes_written;
-    } else if (bytes_written == 0) {
-        // Should not happen with TCP unless bytes_to_send was 0
-        std::cerr << "Client fd=" << _clientFd << ": send() returned 0." << std::endl;
-        return 0;
-    } else { // bytes_written < 0
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // Socket buffer is full, try again later
-             std::cout << "Client fd=" << _clientFd << ": send() would block (EAGAIN/EWOULDBLOCK)." << std::endl;
-            return -2; // Indicate non-blocking would block
-        } else if (errno == EPIPE) {
-             // Client closed connection unexpectedly (broken pipe)
-            std::cerr << "Client fd=" << _clientFd << ": send() failed (Broken pipe)." << std::endl;
-             setState(RESPONSE_SENT); // Mark as done/error
-             return -1;
+
+        if (bytes_written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Socket buffer is full, try again later
+                std::cout << "Client fd=" << _clientFd << ": " << call << "() would block (EAGAIN/EWOULDBLOCK)." << std::endl;
+                return totalSent > 0 ? static_cast<ssize_t>(totalSent) : -2;
+            } else if (errno == EPIPE) {
+                // Client closed connection unexpectedly (broken pipe)
+                std::cerr << "Client fd=" << _clientFd << ": " << call << "() failed (Broken pipe)." << std::endl;
+                setState(RESPONSE_SENT); // Mark as done/error
+                return -1;
+            } else {
+                // Other error
+                perror((std::string(call) + " failed").c_str());
+                setState(RESPONSE_SENT); // Mark as done/error
+                return -1; // Indicate error
+            }
         }
-         else {
-            // Other error
-            perror("send failed");
-            setState(RESPONSE_SENT); // Mark as done/error
-            return -1; // Indicate error
+        totalSent += static_cast<size_t>(bytes_written);
+    }
+
+    // Keep-alive: wait for the next request. Otherwise leave RESPONSE_SENT for the server to close.
+    setState(_keepAlive ? AWAITING_REQUEST : RESPONSE_SENT);
+    return static_cast<ssize_t>(totalSent);
+}
+
+void Client::appendReceived(BufferPool& pool, const char* data, size_t length) {
+    if (!_hasInputBuffer) {
+        pool.acquire(_requestBuffer);
+        _hasInputBuffer = true;
+    }
+    _requestBuffer.append(data, length);
+}
+
+const struct msghdr* Client::prepareSend(int& flags) {
+    if (_responseQueue.empty() || _responseQueue.front().file) {
+        return NULL;
+    }
+    flags = MSG_NOSIGNAL;
+    std::memset(&_sendMsg, 0, sizeof(_sendMsg));
+    _sendMsg.msg_iov = _sendIov;
+    _sendMsg.msg_iovlen = gatherSegments(_sendIov, flags);
+    return &_sendMsg;
+}
+
+char* Client::prepareFileRead(int& fd, size_t& length, off_t& offset) {
+    const OutputSegment& front = _responseQueue.front();
+    fd = front.file->fd;
+    length = std::min(front.fileRemaining, static_cast<size_t>(FILE_READ_CHUNK));
+    offset = front.fileOffset;
+    _fileChunk.resize(length);
+    return &_fileChunk[0];
+}
+
+ssize_t Client::completeSend(int result) {
+    if (result == -EAGAIN || result == -EINTR) {
+        return 0; // Nothing went out: the server submits the send again
+    }
+    if (result < 0) {
+        std::cerr << "Client fd=" << _clientFd << ": sendmsg failed (" << strerror(-result) << ")." << std::endl;
+        setState(RESPONSE_SENT);
+        return -1;
+    }
+    advanceSent(static_cast<size_t>(result));
+    if (_responseQueue.empty()) {
+        setState(_keepAlive ? AWAITING_REQUEST : RESPONSE_SENT);
+    }
+    return result;
+}
+
+// The chunk goes in front of the file range as an ordinary in-memory segment,
+// so the next sendmsg gathers it with whatever follows
+ssize_t Client::completeFileRead(int result) {
+    if (result <= 0) {
+        if (result == 0) {
+            std::cerr << "Client fd=" << _clientFd << ": file ended early, closing." << std::endl;
+        } else {
+            std::cerr << "Client fd=" << _clientFd << ": file read failed (" << strerror(-result) << ")." << std::endl;
         }
+        setState(RESPONSE_SENT);
+        return -1;
     }
+    OutputSegment chunk;
+    chunk.data.swap(_fileChunk);
+    chunk.data.resize(static_cast<size_t>(result));
+    OutputSegment& file = _responseQueue.front();
+    file.fileOffset += result;
+    file.fileRemaining -= static_cast<size_t>(result);
+    if (file.fileRemaining == 0) {
+        chunk.endsResponse = file.endsResponse;
+        _responseQueue.pop_front();
+    }
+    _responseQueue.push_front(std::move(chunk));
+    return result;
+}
+
+bool Client::isSending() const {
+    return _sending;
+}
+
+void Client::setSending(bool sending) {
+    _sending = sending;
+}
+
+unsigned Client::getPendingOperations() const {
+    return _pendingOperations;
+}
+
+void Client::addPendingOperation() {
+    ++_pendingOperations;
+}
+
+void Client::finishPendingOperation() {
+    --_pendingOperations;
+}
+
+void Client::markClosed() {
+    _clientFd = -1;
+}
+
+bool Client::hasPendingOutput() const {
+    return !_responseQueue.empty();
+}
+
+size_t Client::getQueuedResponses() const {
+    return _queuedResponses;
+}
+
+bool Client::hasWriteInterest() const {
+    return _writeInterest;
+}
+
+void Client::setWriteInterest(bool enabled) {
+    _writeInterest = enabled;
+}
+
+TimerNode& Client::getTimer() {
+    return _timer;
+}
+
+ClientTimeout Client::getTimeoutKind() const {
+    return _timeoutKind;
+}
+
+void Client::setTimeoutKind(ClientTimeout kind) {
+    _timeoutKind = kind;
+}
+
+unsigned long Client::getRequestCount() const {
+    return _requestCount;
+}
+
+void Client::incrementRequestCount() {
+    ++_requestCount;
+}
+
+size_t Client::getBufferedBytes() const {
+    size_t bytes = _requestBuffer.size() + _requestBody.getBufferedBytes();
+    for (std::deque<OutputSegment>::const_iterator it = _responseQueue.begin(); it != _responseQueue.end(); ++it) {
+        bytes += it->data.size(); // Cached blobs are shared, file segments stay in the page cache
+    }
+    if (!_responseQueue.empty() && !_responseQueue.front().blob) {
+        bytes -= _bytesSent;
+    }
+    return bytes;
+}
+
+size_t Client::getAccountedBytes() const {
+    return _accountedBytes;
 }
 
-bool Client::isResponseFullySent() const {
-    return _bytesSent == _responseBuffer.length() && !_responseBuffer.empty();
+void Client::setAccountedBytes(size_t bytes) {
+    _accountedBytes = bytes;
 }
 
 // --- Move Constructor ---
 Client::Client(Client&& other) noexcept :
+    EventHandler(CLIENT),
     _clientFd(other._clientFd),
     _clientAddr(other._clientAddr), // sockaddr_in is trivially copyable
     _state(other._state),
     _requestBuffer(std::move(other._requestBuffer)), // Move strings
-    _responseBuffer(std::move(other._responseBuffer)),
+    _responseQueue(std::move(other._responseQueue)),
     _bytesSent(other._bytesSent),
+    _queuedResponses(other._queuedResponses),
     _request(std::move(other._request)), // Assuming Request is movable
-    _requestParsed(other._requestParsed)
+    _requestBody(std::move(other._requestBody)),
+    _keepAlive(other._keepAlive),
+    _writeInterest(other._writeInterest),
+    _timeoutKind(other._timeoutKind), // _timer is not transferred: its links belong to the TimerWheel
+    _requestCount(other._requestCount),
+    _accountedBytes(other._accountedBytes),
+    _hasInputBuffer(other._hasInputBuffer),
+    _serverIndex(other._serverIndex),
+    _fileChunk(std::move(other._fileChunk)), // _sendIov/_sendMsg are rebuilt for every send
+    _sending(other._sending),
+    _pendingOperations(other._pendingOperations)
 {
+    std::memset(&_sendMsg, 0, sizeof(_sendMsg));
     // Leave the moved-from object in a defined (but unusable for socket ops) state
     other._clientFd = -1; // Mark fd as invalid in the source
     other._state = AWAITING_REQUEST; // Or some other safe state
     other._bytesSent = 0;
-    other._requestParsed = false;
+    other._queuedResponses = 0;
+    other._keepAlive = true;
+    other._writeInterest = false;
+    other._timeoutKind = TIMEOUT_NONE;
+    other._requestCount = 0;
+    other._accountedBytes = 0;
+    other._hasInputBuffer = false;
+    other._serverIndex = 0;
+    other._sending = false;
+    other._pendingOperations = 0;
     // std::cout << "Client Move Constructed (fd=" << _clientFd << ")" << std::endl;
 }
 
@@ -223,18 +564,38 @@ Client& Client::operator=(Client&& other) noexcept {
         _clientAddr = other._clientAddr;
         _state = other._state;
         _requestBuffer = std::move(other._requestBuffer);
-        _responseBuffer = std::move(other._responseBuffer);
+        _responseQueue = std::move(other._responseQueue);
         _bytesSent = other._bytesSent;
+        _queuedResponses = other._queuedResponses;
         _request = std::move(other._request); // Assuming Request is movable
-        _requestParsed = other._requestParsed;
+        _requestBody = std::move(other._requestBody); // Takes over (or closes) the temp file
+        _keepAlive = other._keepAlive;
+        _writeInterest = other._writeInterest;
+        _timeoutKind = other._timeoutKind; // _timer stays with its slot (owned by the TimerWheel links)
+        _requestCount = other._requestCount;
+        _accountedBytes = other._accountedBytes;
+        _hasInputBuffer = other._hasInputBuffer;
+        _serverIndex = other._serverIndex;
+        _fileChunk = std::move(other._fileChunk); // _sendIov/_sendMsg stay with the slot
+        _sending = other._sending;
+        _pendingOperations = other._pendingOperations;
 
         // Reset the moved-from object
         other._clientFd = -1;
         other._state = AWAITING_REQUEST;
         other._bytesSent = 0;
-        other._requestParsed = false;
+        other._queuedResponses = 0;
+        other._keepAlive = true;
+        other._writeInterest = false;
+        other._timeoutKind = TIMEOUT_NONE;
+        other._requestCount = 0;
+        other._accountedBytes = 0;
+        other._hasInputBuffer = false;
+        other._serverIndex = 0;
+        other._sending = false;
+        other._pendingOperations = 0;
         other._requestBuffer.clear(); // Clear strings
-        other._responseBuffer.clear();
+        other._responseQueue.clear();
     }
     return *this;
 } 
\ No newline at end of file
@@ -6,34 +6,36 @@
 #include <map> // For storing parsed data
 #include <algorithm> // for std::find
 #include <stack> // Include stack for brace matching
+#include <cstdlib> // For strtol
 
-// --- TODO: Define data structures to hold parsed config ---
-// Example structure (needs refinement based on full subject)
-struct LocationConfig {
-    std::string path;
-    std::string root;
-    std::vector<std::string> allowedMethods;
-    std::vector<std::string> indexFiles;
-    bool autoindex;
-    // ... other location directives (cgi, upload_path, return, limit_except etc.)
-
-    LocationConfig() : autoindex(false) {} // Default autoindex off
-};
-
-struct ServerConfig {
-    std::vector<std::pair<std::string, int> > listens; // host:port pairs
-    std::vector<std::string> serverNames;
-    std::string root; // Default root for the server
-    std::vector<std::string> indexFiles; // Default index files
-    std::map<int, std::string> errorPages; // map status code to path
-    size_t clientMaxBodySize;
-    std::vector<LocationConfig> locations;
-
-    ServerConfig() : clientMaxBodySize(1048576) {} // Default 1MB
-};
-// --- End Config Structures ---
-
-Config::Config(const std::string& filename) : _filename(filename) {
+static bool parseSizeBytes(const std::string& value, size_t& bytes); // Defined with the global directive helpers
+
+Config::Config(const std::string& filename) :
+    _filename(filename),
+    _workerThreads(1),
+    _workerProcesses(0),
+    _acceptBatch(64),
+    _workerConnections(1024),
+    _eventBackend("epoll"),
+    _clientHeaderTimeoutMs(60000),
+    _clientBodyTimeoutMs(60000),
+    _keepaliveTimeoutMs(75000),
+    _sendTimeoutMs(60000),
+    _keepaliveRequests(1000),
+    _workerMemoryLimit(0),
+    _overload503(false),
+    _clientBodyTempPath("/tmp"),
+    _sendfileThreshold(16384),
+    _openFileCacheMax(1024),
+    _openFileCacheValidMs(60000),
+    _responseCacheSize(1024 * 1024),
+    _etag("on"),
+    _gzipStatic(false),
+    _gzip(false),
+    _gzipMinLength(1024),
+    _gzipCacheSize(8 * 1024 * 1024),
+    _gzipMaxLength(0)
+{
     // Constructor implementation
     // Consider calling load() here or requiring explicit call
     std::cout << "Config object created for file: " << _filename << std::endl;
@@ -118,8 +120,7 @@ bool Config::load() {
 
              if (brace_stack.empty() && in_server_block) { // If stack is now empty, it's the end of the server block
                  in_server_block = false;
-                 // TODO: Store the completed currentServer
-                 // _servers.push_back(currentServer);
+                 _servers.push_back(currentServer);
                  std::cout << "Exiting server block (line " << lineNumber << ")" << std::endl;
                  continue;
              } else if (!brace_stack.empty()) {
@@ -148,9 +149,18 @@ bool Config::load() {
                  std::string listen_arg;
                  lineStream >> listen_arg;
                  if (!listen_arg.empty() && listen_arg.back() == ';') listen_arg.pop_back();
-                 // TODO: Parse host:port properly
-                 if (listen_arg == "127.0.0.1:8080") {
-                     currentServer.listens.push_back(std::make_pair("127.0.0.1", 8080));
+                 // Accept "host:port" or a bare "port" (all interfaces)
+                 std::string host = "0.0.0.0";
+                 std::string portStr = listen_arg;
+                 size_t colon = listen_arg.find(':');
+                 if (colon != std::string::npos) {
+                     host = listen_arg.substr(0, colon);
+                     portStr = listen_arg.substr(colon + 1);
+                 }
+                 std::istringstream portStream(portStr);
+                 int port = 0;
+                 if (!host.empty() && (portStream >> port) && portStream.eof() && port > 0 && port < 65536) {
+                     currentServer.listens.push_back(std::make_pair(host, port));
                  } else { std::cerr << "Warning: Unrecognized listen format (line " << lineNumber << "): " << line << std::endl; }
             } else if (directive == "server_name") {
                  std::string name;
@@ -170,12 +180,45 @@ bool Config::load() {
                      currentServer.indexFiles.push_back(index_file);
                  }
             } else if (directive == "error_page") {
-                int code;
-                std::string page_path;
-                if (lineStream >> code >> page_path) {
-                     if (!page_path.empty() && page_path.back() == ';') page_path.pop_back();
-                    currentServer.errorPages[code] = page_path;
-                } else { std::cerr << "Warning: Failed to parse error_page (line " << lineNumber << "): " << line << std::endl; }
+                // error_page code... path: every code listed before the path maps to it
+                std::vector<std::string> args;
+                std::string arg;
+                while (lineStream >> arg) {
+                    if (!arg.empty() && arg.back() == ';') arg.pop_back();
+                    if (!arg.empty()) args.push_back(arg);
+                }
+                if (args.size() < 2) {
+                    std::cerr << "Warning: Failed to parse error_page (line " << lineNumber << "): " << line << std::endl;
+                } else {
+                    const std::string& page_path = args.back();
+                    for (size_t i = 0; i + 1 < args.size(); ++i) {
+                        char* end = NULL;
+                        long code = std::strtol(args[i].c_str(), &end, 10);
+                        if (*end != '\0' || code < 300 || code > 599) {
+                            std::cerr << "Warning: error_page code must be between 300 and 599 (line " << lineNumber << "): " << args[i] << std::endl;
+                            continue;
+                        }
+                        currentServer.errorPages[static_cast<int>(code)] = page_path;
+                    }
+                }
+             } else if (directive == "client_max_body_size") {
+                 std::string value;
+                 std::getline(lineStream >> std::ws, value);
+                 if (!value.empty() && value.back() == ';') value.pop_back();
+                 if (!parseSizeBytes(value, currentServer.clientMaxBodySize)) {
+                     std::cerr << "Error: client_max_body_size must be a size such as 8m, 0 for unlimited (line "
+                               << lineNumber << "): " << line << std::endl;
+                     return false;
+                 }
+             } else if (directive == "client_body_buffer_size") {
+                 std::string value;
+                 std::getline(lineStream >> std::ws, value);
+                 if (!value.empty() && value.back() == ';') value.pop_back();
+                 if (!parseSizeBytes(value, currentServer.clientBodyBufferSize)) {
+                     std::cerr << "Error: client_body_buffer_size must be a size such as 16k (line "
+                               << lineNumber << "): " << line << std::endl;
+                     return false;
+                 }
              }
              // Ignore location directives at this level
              else if (directive == "location") {
@@ -185,8 +228,10 @@ bool Config::load() {
                 std::cerr << "Warning: Unknown server directive '" << directive << "' (line " << lineNumber << ")" << std::endl;
             }
         } else if (!in_server_block && !line.empty()) {
-            // Outside any block - should be an error unless it's a top-level directive (e.g., 'worker_processes' in Nginx)
-            std::cerr << "Warning: Directive outside server block ignored (line " << lineNumber << "): " << line << std::endl;
+            // Outside any block - only global directives (e.g., 'worker_threads', like 'worker_processes' in Nginx)
+            if (!parseGlobalDirective(line, lineNumber)) {
+                return false;
+            }
         } else if (in_server_block && brace_stack.size() > 1) {
              // Inside a nested block (location) - content is skipped currently
              // std::cout << "Skipping content inside nested block (line " << lineNumber << "): " << line << std::endl;
@@ -202,19 +247,325 @@ bool Config::load() {
          std::cerr << "Error: Server block not properly closed at end of file." << std::endl;
          return false;
      }
+    // Pre-fork workers share their listeners and rely on EPOLLEXCLUSIVE to avoid waking
+    // every worker per connection; io_uring polls have no equivalent
+    if (_eventBackend == "io_uring" && _workerProcesses > 0) {
+        std::cerr << "Error: event_backend io_uring can't be combined with worker_processes "
+                  << "(no EPOLLEXCLUSIVE equivalent); use epoll, or worker_threads." << std::endl;
+        return false;
+    }
 
 
     // --- Placeholder: Print parsed data ---
     std::cout << "--- Parsed Config (Placeholder) ---" << std::endl;
-    for(size_t i = 0; i < currentServer.listens.size(); ++i) std::cout << "Listen: " << currentServer.listens[i].first << ":" << currentServer.listens[i].second << std::endl;
-    std::cout << "Root: " << currentServer.root << std::endl;
-    std::cout << "Index: "; for(size_t i = 0; i< currentServer.indexFiles.size(); ++i) std::cout << currentServer.indexFiles[i] << " "; std::cout << std::endl;
-    for(std::map<int, std::string>::const_iterator it = currentServer.errorPages.begin(); it != currentServer.errorPages.end(); ++it) std::cout << "Error Page " << it->first << ": " << it->second << std::endl;
+    for (size_t s = 0; s < _servers.size(); ++s) {
+        const ServerConfig& server = _servers[s];
+        for(size_t i = 0; i < server.listens.size(); ++i) std::cout << "Listen: " << server.listens[i].first << ":" << server.listens[i].second << std::endl;
+        std::cout << "Root: " << server.root << std::endl;
+        std::cout << "Index: "; for(size_t i = 0; i< server.indexFiles.size(); ++i) std::cout << server.indexFiles[i] << " "; std::cout << std::endl;
+        for(std::map<int, std::string>::const_iterator it = server.errorPages.begin(); it != server.errorPages.end(); ++it) std::cout << "Error Page " << it->first << ": " << it->second << std::endl;
+        std::cout << "Client max body size: " << server.clientMaxBodySize << " bytes, buffered in memory up to "
+                  << server.clientBodyBufferSize << " bytes" << std::endl;
+    }
+    std::cout << "Worker threads: " << _workerThreads << std::endl;
+    std::cout << "Worker processes: " << _workerProcesses << std::endl;
+    std::cout << "Accept batch: " << _acceptBatch << std::endl;
+    std::cout << "Worker connections: " << _workerConnections << std::endl;
+    std::cout << "Event backend: " << _eventBackend << std::endl;
+    std::cout << "Timeouts (ms): header " << _clientHeaderTimeoutMs << ", body " << _clientBodyTimeoutMs
+              << ", keepalive " << _keepaliveTimeoutMs << ", send " << _sendTimeoutMs << std::endl;
+    std::cout << "Keep-alive requests: " << _keepaliveRequests << std::endl;
+    std::cout << "Client body temp path: " << _clientBodyTempPath << std::endl;
+    std::cout << "Sendfile threshold: " << _sendfileThreshold << " bytes" << std::endl;
+    std::cout << "Open file cache: " << _openFileCacheMax << " entries, valid " << _openFileCacheValidMs << " ms" << std::endl;
+    std::cout << "Response cache: " << _responseCacheSize << " bytes" << std::endl;
+    std::cout << "ETag: " << _etag << std::endl;
+    std::cout << "gzip_static: " << (_gzipStatic ? "on" : "off") << ", gzip: " << (_gzip ? "on" : "off")
+              << " (min length " << _gzipMinLength << ", max length " << getGzipMaxLength()
+              << ", cache " << _gzipCacheSize << " bytes)" << std::endl;
+    std::cout << "Worker memory limit: " << _workerMemoryLimit << " bytes, overload 503: "
+              << (_overload503 ? "on" : "off") << std::endl;
     std::cout << "---------------------------------" << std::endl;
 
     return true; // Assume success if no fatal parse errors occurred
 }
 
+// Parse a duration such as "30", "30s", "500ms" or "2m" (bare numbers are seconds)
+static bool parseDurationMs(const std::string& value, unsigned long& ms) {
+    std::istringstream valueStream(value);
+    unsigned long amount = 0;
+    if (value.empty() || value[0] == '-' || !(valueStream >> amount)) {
+        return false;
+    }
+    std::string unit;
+    valueStream >> unit;
+    if (unit.empty() || unit == "s") ms = amount * 1000;
+    else if (unit == "ms") ms = amount;
+    else if (unit == "m") ms = amount * 60 * 1000;
+    else return false;
+    return true;
+}
+
+// Parse a size such as "4096", "64k", "10m" or "1g" (bare numbers are bytes)
+static bool parseSizeBytes(const std::string& value, size_t& bytes) {
+    std::istringstream valueStream(value);
+    unsigned long amount = 0;
+    if (value.empty() || value[0] == '-' || !(valueStream >> amount)) {
+        return false;
+    }
+    std::string unit;
+    valueStream >> unit;
+    if (unit.empty()) bytes = amount;
+    else if (unit == "k" || unit == "K") bytes = amount * 1024UL;
+    else if (unit == "m" || unit == "M") bytes = amount * 1024UL * 1024UL;
+    else if (unit == "g" || unit == "G") bytes = amount * 1024UL * 1024UL * 1024UL;
+    else return false;
+    return true;
+}
+
+// Parse a directive found outside any server block.
+// Returns false only on a fatal error (bad value); unknown directives are warned about and ignored.
+bool Config::parseGlobalDirective(const std::string& line, int lineNumber) {
+    std::istringstream lineStream(line);
+    std::string directive;
+    std::string value;
+    lineStream >> directive >> value;
+    if (!directive.empty() && directive.back() == ';') directive.pop_back();
+    if (!value.empty() && value.back() == ';') value.pop_back();
+
+    if (directive == "worker_threads") {
+        std::istringstream valueStream(value);
+        int threads = 0;
+        if (!(valueStream >> threads) || threads < 1) {
+            std::cerr << "Error: worker_threads must be a positive integer (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _workerThreads = threads;
+    } else if (directive == "worker_processes") {
+        std::istringstream valueStream(value);
+        int processes = -1;
+        if (!(valueStream >> processes) || processes < 0) {
+            std::cerr << "Error: worker_processes must be a non-negative integer (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _workerProcesses = processes;
+    } else if (directive == "accept_batch") {
+        std::istringstream valueStream(value);
+        int batch = 0;
+        if (!(valueStream >> batch) || batch < 1) {
+            std::cerr << "Error: accept_batch must be a positive integer (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _acceptBatch = batch;
+    } else if (directive == "worker_connections") {
+        std::istringstream valueStream(value);
+        int connections = 0;
+        if (!(valueStream >> connections) || connections < 1) {
+            std::cerr << "Error: worker_connections must be a positive integer (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _workerConnections = connections;
+    } else if (directive == "event_backend") {
+        if (value != "epoll" && value != "io_uring") {
+            std::cerr << "Error: event_backend must be 'epoll' or 'io_uring' (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _eventBackend = value;
+    } else if (directive == "client_header_timeout" || directive == "client_body_timeout"
+               || directive == "keepalive_timeout" || directive == "send_timeout") {
+        unsigned long ms = 0;
+        if (!parseDurationMs(value, ms)) {
+            std::cerr << "Error: " << directive << " must be a duration like 60s or 500ms (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        if (directive == "client_header_timeout") _clientHeaderTimeoutMs = ms;
+        else if (directive == "client_body_timeout") _clientBodyTimeoutMs = ms;
+        else if (directive == "keepalive_timeout") _keepaliveTimeoutMs = ms;
+        else _sendTimeoutMs = ms;
+    } else if (directive == "keepalive_requests") {
+        std::istringstream valueStream(value);
+        long requests = -1;
+        if (!(valueStream >> requests) || requests < 0) {
+            std::cerr << "Error: keepalive_requests must be a non-negative integer (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _keepaliveRequests = static_cast<unsigned long>(requests);
+    } else if (directive == "worker_memory_limit") {
+        if (!parseSizeBytes(value, _workerMemoryLimit)) {
+            std::cerr << "Error: worker_memory_limit must be a size like 64m or 0 (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+    } else if (directive == "overload_503") {
+        if (value != "on" && value != "off") {
+            std::cerr << "Error: overload_503 must be 'on' or 'off' (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _overload503 = (value == "on");
+    } else if (directive == "client_body_temp_path") {
+        if (value.empty()) {
+            std::cerr << "Error: client_body_temp_path needs a directory (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _clientBodyTempPath = value;
+    } else if (directive == "open_file_cache") {
+        // open_file_cache off | max=N [valid=time]
+        std::string args;
+        std::getline(lineStream, args);
+        args = value + args;
+        if (!args.empty() && args[args.size() - 1] == ';') args.erase(args.size() - 1);
+        std::istringstream argStream(args);
+        std::string arg;
+        bool ok = true;
+        size_t maxEntries = _openFileCacheMax;
+        unsigned long validMs = _openFileCacheValidMs;
+        while (ok && argStream >> arg) {
+            if (arg == "off") {
+                maxEntries = 0;
+            } else if (arg.compare(0, 4, "max=") == 0) {
+                std::istringstream countStream(arg.substr(4));
+                long count = 0;
+                ok = (countStream >> count) && countStream.eof() && count > 0;
+                maxEntries = static_cast<size_t>(count);
+            } else if (arg.compare(0, 6, "valid=") == 0) {
+                ok = parseDurationMs(arg.substr(6), validMs) && validMs > 0;
+            } else {
+                ok = false;
+            }
+        }
+        if (!ok || value.empty()) {
+            std::cerr << "Error: open_file_cache must be 'off' or 'max=N [valid=60s]' (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _openFileCacheMax = maxEntries;
+        _openFileCacheValidMs = validMs;
+    } else if (directive == "sendfile_threshold") {
+        if (!parseSizeBytes(value, _sendfileThreshold)) {
+            std::cerr << "Error: sendfile_threshold must be a size such as 16k (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+    } else if (directive == "response_cache_size") {
+        if (value == "off") {
+            _responseCacheSize = 0;
+        } else if (!parseSizeBytes(value, _responseCacheSize)) {
+            std::cerr << "Error: response_cache_size must be a size such as 1m or 'off' (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+    } else if (directive == "etag") {
+        if (value != "on" && value != "weak" && value != "off") {
+            std::cerr << "Error: etag must be 'on', 'weak' or 'off' (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        _etag = value;
+    } else if (directive == "gzip_static" || directive == "gzip") {
+        if (value != "on" && value != "off") {
+            std::cerr << "Error: " << directive << " must be 'on' or 'off' (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+        (directive == "gzip" ? _gzip : _gzipStatic) = (value == "on");
+    } else if (directive == "gzip_min_length") {
+        if (!parseSizeBytes(value, _gzipMinLength)) {
+            std::cerr << "Error: gzip_min_length must be a size such as 1k (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+    } else if (directive == "gzip_cache_size") {
+        if (!parseSizeBytes(value, _gzipCacheSize)) {
+            std::cerr << "Error: gzip_cache_size must be a size such as 8m (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+    } else if (directive == "gzip_max_length") {
+        if (!parseSizeBytes(value, _gzipMaxLength) || _gzipMaxLength == 0) {
+            std::cerr << "Error: gzip_max_length must be a size such as 1m (line " << lineNumber << "): " << line << std::endl;
+            return false;
+        }
+    } else {
+        std::cerr << "Warning: Directive outside server block ignored (line " << lineNumber << "): " << line << std::endl;
+    }
+    return true;
+}
+
+int Config::getWorkerThreads() const {
+    return _workerThreads;
+}
+
+int Config::getWorkerProcesses() const {
+    return _workerProcesses;
+}
+
+int Config::getAcceptBatch() const {
+    return _acceptBatch;
+}
+
+int Config::getWorkerConnections() const {
+    return _workerConnections;
+}
+
+const std::string& Config::getEventBackend() const {
+    return _eventBackend;
+}
+
+unsigned long Config::getClientHeaderTimeoutMs() const { return _clientHeaderTimeoutMs; }
+unsigned long Config::getClientBodyTimeoutMs() const { return _clientBodyTimeoutMs; }
+unsigned long Config::getKeepaliveTimeoutMs() const { return _keepaliveTimeoutMs; }
+unsigned long Config::getSendTimeoutMs() const { return _sendTimeoutMs; }
+unsigned long Config::getKeepaliveRequests() const { return _keepaliveRequests; }
+size_t Config::getWorkerMemoryLimit() const { return _workerMemoryLimit; }
+bool Config::getOverload503() const { return _overload503; }
+const std::string& Config::getClientBodyTempPath() const { return _clientBodyTempPath; }
+size_t Config::getSendfileThreshold() const { return _sendfileThreshold; }
+size_t Config::getOpenFileCacheMax() const { return _openFileCacheMax; }
+unsigned long Config::getOpenFileCacheValidMs() const { return _openFileCacheValidMs; }
+size_t Config::getResponseCacheSize() const { return _responseCacheSize; }
+const std::string& Config::getEtag() const { return _etag; }
+bool Config::getGzipStatic() const { return _gzipStatic; }
+bool Config::getGzip() const { return _gzip; }
+size_t Config::getGzipMinLength() const { return _gzipMinLength; }
+size_t Config::getGzipCacheSize() const { return _gzipCacheSize; }
+// Anything compressed on the fly must fit in the gzip cache, or it would be compressed on every request
+size_t Config::getGzipMaxLength() const {
+    return (_gzipMaxLength == 0 || _gzipMaxLength > _gzipCacheSize) ? _gzipCacheSize : _gzipMaxLength;
+}
+
+const std::vector<ServerConfig>& Config::getServers() const {
+    return _servers;
+}
+
+size_t Config::getServerIndex(const std::pair<std::string, int>& listen) const {
+    for (size_t s = 0; s < _servers.size(); ++s) {
+        if (std::find(_servers[s].listens.begin(), _servers[s].listens.end(), listen) != _servers[s].listens.end()) {
+            return s;
+        }
+    }
+    return 0;
+}
+
+std::string Config::getRoot(size_t server) const {
+    std::string root = DEFAULT_ROOT;
+    if (server < _servers.size() && !_servers[server].root.empty()) {
+        root = _servers[server].root;
+    }
+    if (root.length() > 1 && root[root.length() - 1] == '/') {
+        root.erase(root.length() - 1); // "/" stays "/"
+    }
+    return root;
+}
+
+// Unique host:port pairs across all server blocks, in config order.
+// Falls back to 127.0.0.1:8080 when no server declares a listen directive.
+std::vector<std::pair<std::string, int> > Config::getListeners() const {
+    std::vector<std::pair<std::string, int> > listeners;
+    for (size_t s = 0; s < _servers.size(); ++s) {
+        for (size_t i = 0; i < _servers[s].listens.size(); ++i) {
+            if (std::find(listeners.begin(), listeners.end(), _servers[s].listens[i]) == listeners.end()) {
+                listeners.push_back(_servers[s].listens[i]);
+            }
+        }
+    }
+    if (listeners.empty()) {
+        listeners.push_back(std::make_pair("127.0.0.1", 8080));
+    }
+    return listeners;
+}
+
 // Placeholder for parsing logic
 bool Config::parseFile() {
     // Implementation needed
@@ -0,0 +1,71 @@
+#include "EpollPoller.hpp"
+#include <iostream>
+#include <stdexcept> // For runtime_error
+#include <unistd.h>  // for close
+#include <cstring>   // for memset
+#include <cstdio>    // for perror
+
+EpollPoller::EpollPoller() : _epollFd(-1) {
+    std::memset(_events, 0, sizeof(_events)); // Clear events buffer
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd < 0) {
+        perror("epoll_create1 failed");
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+    std::cout << "Epoll instance created (fd=" << _epollFd << ")." << std::endl;
+}
+
+EpollPoller::~EpollPoller() {
+    if (_epollFd >= 0) {
+        std::cout << "Closing epoll fd: " << _epollFd << std::endl;
+        close(_epollFd);
+    }
+}
+
+const char* EpollPoller::name() const {
+    return "epoll";
+}
+
+void EpollPoller::add(int fd, uint32_t events, EventHandler* handler) {
+    struct epoll_event event;
+    event.data.ptr = handler; // Dispatch goes straight to the tagged handler object
+    event.events = events; // e.g., EPOLLIN | EPOLLOUT | EPOLLET (Edge Triggered)
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        perror("epoll_ctl(ADD) failed");
+        throw std::runtime_error("Failed to add socket to epoll");
+    }
+}
+
+bool EpollPoller::modify(int fd, uint32_t events, EventHandler* handler) {
+    struct epoll_event event;
+    event.data.ptr = handler;
+    event.events = events;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &event) < 0) {
+        perror("epoll_ctl(MOD) failed");
+        return false;
+    }
+    return true;
+}
+
+void EpollPoller::remove(int fd) {
+    if (fd >= 0 && epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, NULL) < 0) {
+        perror("epoll_ctl(DEL) failed");
+        // Log error, but might not need to throw, maybe the fd was already closed
+    }
+}
+
+int EpollPoller::wait(PollerEvent* events, int maxEvents, int timeoutMs) {
+    if (maxEvents > EPOLL_BATCH_SIZE) {
+        maxEvents = EPOLL_BATCH_SIZE;
+    }
+    int numEvents = epoll_wait(_epollFd, _events, maxEvents, timeoutMs);
+    for (int i = 0; i < numEvents; ++i) {
+        events[i].handler = static_cast<EventHandler*>(_events[i].data.ptr);
+        events[i].events = _events[i].events;
+        events[i].op = POLLER_READY;
+        events[i].result = 0;
+        events[i].data = NULL;
+        events[i].more = false;
+    }
+    return numEvents;
+}
@@ -0,0 +1,123 @@
+#include "ErrorPages.hpp"
+#include "HttpDate.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// Every code the server answers with a generated page (502-504 for error_page 50x lines)
+static const int ERROR_CODES[] = { 400, 403, 404, 405, 413, 414, 416, 431, 500, 501, 502, 503, 504, 505 };
+
+ErrorPages::ErrorPages() {}
+
+bool ErrorPages::isErrorCode(int code) {
+    for (size_t i = 0; i < sizeof(ERROR_CODES) / sizeof(ERROR_CODES[0]); ++i) {
+        if (ERROR_CODES[i] == code) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string ErrorPages::defaultBody(int code) {
+    std::string reason = Response::getDefaultStatusMessage(code);
+    std::ostringstream oss;
+    oss << "<html><head><title>" << code << " " << reason << "</title></head>"
+        << "<body><h1>" << code << " " << reason << "</h1>"
+        << "<p>Error processing request.</p><hr><p>webserv</p></body></html>";
+    return oss.str();
+}
+
+bool ErrorPages::readPage(const std::string& path, std::string& body) {
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    if (file.bad()) {
+        return false;
+    }
+    body = contents.str();
+    return true;
+}
+
+Response ErrorPages::makeResponse(int code, const std::string& body) {
+    Response response;
+    response.setVersion("HTTP/1.1");
+    response.setStatusCode(code);
+    response.setHeader(HEADER_CONTENT_TYPE, "text/html");
+    response.setHeader(HEADER_CONTENT_LENGTH, std::to_string(body.length()));
+    response.setBody(body);
+    return response;
+}
+
+void ErrorPages::load(const Config& config) {
+    const std::vector<ServerConfig>& servers = config.getServers();
+    _pages.assign(servers.empty() ? 1 : servers.size(), PageMap()); // Built-in pages even without a server block
+
+    for (size_t vhost = 0; vhost < _pages.size(); ++vhost) {
+        std::map<int, std::string> configured;
+        std::string root = config.getRoot(vhost); // The docroot generateResponse serves from
+        if (vhost < servers.size()) {
+            configured = servers[vhost].errorPages;
+        }
+        for (std::map<int, std::string>::const_iterator it = configured.begin(); it != configured.end(); ++it) {
+            if (!isErrorCode(it->first)) {
+                std::cerr << "Warning: error_page " << it->first << " is not a status this server sends; ignored." << std::endl;
+            }
+        }
+
+        size_t loaded = 0;
+        for (size_t i = 0; i < sizeof(ERROR_CODES) / sizeof(ERROR_CODES[0]); ++i) {
+            int code = ERROR_CODES[i];
+            Entry entry;
+            std::map<int, std::string>::const_iterator page = configured.find(code);
+            if (page == configured.end() || !readPage(root + page->second, entry.body)) {
+                if (page != configured.end()) {
+                    std::cerr << "Warning: error_page " << code << " file " << root + page->second
+                              << " could not be read; using the built-in page." << std::endl;
+                }
+                entry.body = defaultBody(code);
+            } else {
+                ++loaded;
+            }
+
+            std::string serialized = makeResponse(code, entry.body).toCacheableString();
+            entry.dateSecond = HttpDate::now();
+            if (ResponseCache::locate(serialized, entry.headEnd, entry.dateOffset)) {
+                entry.blob = std::make_shared<std::string>(std::move(serialized));
+            } // Otherwise the Date can't be patched: find() misses and build() is used
+            _pages[vhost][code] = std::move(entry);
+        }
+        std::cout << "Error pages for server " << vhost << ": " << _pages[vhost].size()
+                  << " built, " << loaded << " from error_page files." << std::endl;
+    }
+}
+
+bool ErrorPages::find(size_t vhost, int code, CachedResponse& out) {
+    if (vhost >= _pages.size()) {
+        return false;
+    }
+    PageMap::iterator it = _pages[vhost].find(code);
+    if (it == _pages[vhost].end()) {
+        return false;
+    }
+    Entry& entry = it->second;
+    if (!entry.blob) {
+        return false;
+    }
+    ResponseCache::refreshDate(entry.blob, entry.dateOffset, entry.dateSecond);
+    out.blob = entry.blob;
+    out.headEnd = entry.headEnd;
+    return true;
+}
+
+Response ErrorPages::build(size_t vhost, int code) const {
+    if (vhost < _pages.size()) {
+        PageMap::const_iterator it = _pages[vhost].find(code);
+        if (it != _pages[vhost].end()) {
+            return makeResponse(code, it->second.body);
+        }
+    }
+    return makeResponse(code, defaultBody(code));
+}
@@ -0,0 +1,85 @@
+#include "HeaderId.hpp"
+#include <strings.h> // For strncasecmp
+#include <cstring>   // For strlen
+
+// Indexed by HeaderId
+static const char* const HEADER_NAMES[HEADER_COUNT] = {
+    "",
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Ranges",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expect",
+    "Host",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "Keep-Alive",
+    "Last-Modified",
+    "Location",
+    "Range",
+    "Referer",
+    "Retry-After",
+    "Server",
+    "TE",
+    "Trailer",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+    "Vary"
+};
+
+#define HEADER_HASH_SIZE 128
+
+// length + 3 * first + 15 * last (letters folded to lower case) is collision-free
+// for HEADER_NAMES in a 128-slot table; re-check when adding a name.
+static inline unsigned headerHash(const char* name, size_t length) {
+    unsigned first = static_cast<unsigned char>(name[0]) | 0x20;
+    unsigned last = static_cast<unsigned char>(name[length - 1]) | 0x20;
+    return (static_cast<unsigned>(length) + 3 * first + 15 * last) & (HEADER_HASH_SIZE - 1);
+}
+
+struct HeaderHashTable {
+    unsigned char slots[HEADER_HASH_SIZE]; // HeaderId, HEADER_UNKNOWN if empty
+    size_t lengths[HEADER_COUNT];
+
+    HeaderHashTable() {
+        std::memset(slots, HEADER_UNKNOWN, sizeof(slots));
+        lengths[HEADER_UNKNOWN] = 0;
+        for (int id = HEADER_UNKNOWN + 1; id < HEADER_COUNT; ++id) {
+            lengths[id] = std::strlen(HEADER_NAMES[id]);
+            slots[headerHash(HEADER_NAMES[id], lengths[id])] = static_cast<unsigned char>(id);
+        }
+    }
+};
+
+static const HeaderHashTable g_headerTable;
+
+HeaderId KnownHeaders::lookup(const char* name, size_t length) {
+    if (length == 0) {
+        return HEADER_UNKNOWN;
+    }
+    HeaderId id = static_cast<HeaderId>(g_headerTable.slots[headerHash(name, length)]);
+    // One candidate per slot: confirm it (the hash only looks at 3 properties of the name)
+    if (id != HEADER_UNKNOWN && g_headerTable.lengths[id] == length
+        && strncasecmp(HEADER_NAMES[id], name, length) == 0) {
+        return id;
+    }
+    return HEADER_UNKNOWN;
+}
+
+const char* KnownHeaders::name(HeaderId id) {
+    return (id > HEADER_UNKNOWN && id < HEADER_COUNT) ? HEADER_NAMES[id] : "";
+}
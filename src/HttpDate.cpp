@@ -0,0 +1,59 @@
+#include "HttpDate.hpp"
+#include <cstring> // For memset
+
+#define HTTP_DATE_FORMAT "%a, %d %b %Y %H:%M:%S GMT"
+
+static thread_local time_t cachedSecond = 0;
+static thread_local char cachedDate[HTTP_DATE_LENGTH + 1];
+
+void HttpDate::refresh() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    if (ts.tv_sec == cachedSecond) {
+        return;
+    }
+    struct tm tm;
+    gmtime_r(&ts.tv_sec, &tm);
+    strftime(cachedDate, sizeof(cachedDate), HTTP_DATE_FORMAT, &tm);
+    cachedSecond = ts.tv_sec;
+}
+
+const char* HttpDate::current() {
+    if (cachedSecond == 0) {
+        refresh(); // First use on this thread
+    }
+    return cachedDate;
+}
+
+time_t HttpDate::now() {
+    if (cachedSecond == 0) {
+        refresh();
+    }
+    return cachedSecond;
+}
+
+std::string HttpDate::format(time_t when) {
+    char buffer[HTTP_DATE_LENGTH + 1];
+    struct tm tm;
+    gmtime_r(&when, &tm);
+    size_t length = strftime(buffer, sizeof(buffer), HTTP_DATE_FORMAT, &tm);
+    return std::string(buffer, length);
+}
+
+bool HttpDate::parse(const std::string& value, time_t& when) {
+    static const char* const formats[] = {
+        HTTP_DATE_FORMAT,             // Sun, 06 Nov 1994 08:49:37 GMT
+        "%A, %d-%b-%y %H:%M:%S GMT",  // Sunday, 06-Nov-94 08:49:37 GMT
+        "%a %b %e %H:%M:%S %Y"        // Sun Nov  6 08:49:37 1994
+    };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+        struct tm tm;
+        std::memset(&tm, 0, sizeof(tm));
+        const char* end = strptime(value.c_str(), formats[i], &tm);
+        if (end && *end == '\0') {
+            when = timegm(&tm);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,488 @@
+#include "IoUringPoller.hpp"
+#include <iostream>
+#include <stdexcept>    // For runtime_error
+#include <unistd.h>     // for close, syscall
+#include <sys/syscall.h> // for __NR_io_uring_*
+#include <sys/mman.h>   // for mmap
+#include <poll.h>       // for POLLIN/POLLOUT
+#include <cstring>      // for memset
+#include <cerrno>       // for errno
+#include <cstdio>       // for perror
+#include <ctime>        // for timespec
+#include <sys/socket.h> // for SOCK_CLOEXEC, shutdown
+
+// user_data layout. Polls: IOURING_POLL_TAG, the fd in bits 32-62 and the
+// registration generation in the low 32. Operations: the handler pointer with
+// the PollerOp in the low 2 bits (handlers are at least 4-byte aligned).
+// POLL_REMOVE, ASYNC_CANCEL and CLOSE carry 0 so their completions are skipped.
+#define IOURING_POLL_TAG (1ULL << 63)
+#define IOURING_IGNORE_TAG 0ULL
+#define IOURING_OP_MASK 3ULL
+
+static uint64_t pollUserData(int fd, uint32_t generation) {
+    return IOURING_POLL_TAG | (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32) | generation;
+}
+
+IoUringPoller::IoUringPoller() :
+    _ringFd(-1),
+    _sqRingPtr(MAP_FAILED), _sqRingSize(0),
+    _sqHead(NULL), _sqTail(NULL), _sqRingMask(NULL), _sqArray(NULL),
+    _sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)), _sqesSize(0),
+    _cqRingPtr(MAP_FAILED), _cqRingSize(0),
+    _cqHead(NULL), _cqTail(NULL), _cqRingMask(NULL), _cqes(NULL),
+    _completions(false), _bufRing(NULL), _bufRingSize(0), _bufRingTail(0)
+{
+    // DEFER_TASKRUN (6.1): completions are run when this thread waits instead of
+    // interrupting it. It requires SINGLE_ISSUER: a Server's ring is only used by
+    // the thread that created it in init().
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    _ringFd = static_cast<int>(syscall(__NR_io_uring_setup, IOURING_QUEUE_DEPTH, &params));
+    bool deferTaskrun = _ringFd >= 0;
+    if (_ringFd < 0 && errno == EINVAL) {
+        std::memset(&params, 0, sizeof(params)); // Older kernel: readiness mode only
+        _ringFd = static_cast<int>(syscall(__NR_io_uring_setup, IOURING_QUEUE_DEPTH, &params));
+    }
+    if (_ringFd < 0) {
+        perror("io_uring_setup failed");
+        throw std::runtime_error("Failed to create io_uring instance");
+    }
+    // EXT_ARG is needed for waits with a timeout, NODROP so completions are never lost
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+        close(_ringFd);
+        throw std::runtime_error("io_uring lacks EXT_ARG/NODROP support (kernel too old)");
+    }
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap && _cqRingSize > _sqRingSize) {
+        _sqRingSize = _cqRingSize;
+    }
+
+    _sqRingPtr = mmap(NULL, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      _ringFd, IORING_OFF_SQ_RING);
+    if (_sqRingPtr == MAP_FAILED) {
+        perror("mmap(SQ ring) failed");
+        close(_ringFd);
+        throw std::runtime_error("Failed to map io_uring submission queue");
+    }
+    if (singleMmap) {
+        _cqRingPtr = _sqRingPtr;
+    } else {
+        _cqRingPtr = mmap(NULL, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          _ringFd, IORING_OFF_CQ_RING);
+        if (_cqRingPtr == MAP_FAILED) {
+            perror("mmap(CQ ring) failed");
+            munmap(_sqRingPtr, _sqRingSize);
+            close(_ringFd);
+            throw std::runtime_error("Failed to map io_uring completion queue");
+        }
+    }
+
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      _ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        perror("mmap(SQEs) failed");
+        if (!singleMmap) munmap(_cqRingPtr, _cqRingSize);
+        munmap(_sqRingPtr, _sqRingSize);
+        close(_ringFd);
+        throw std::runtime_error("Failed to map io_uring SQE array");
+    }
+    _sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(_sqRingPtr);
+    _sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sqRingMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(_cqRingPtr);
+    _cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cqRingMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    _completions = deferTaskrun && setupCompletions();
+
+    std::cout << "io_uring instance created (fd=" << _ringFd << ", " << params.sq_entries
+              << " SQ / " << params.cq_entries << " CQ entries, "
+              << (_completions ? "accept/recv/send through the ring" : "readiness only") << ")." << std::endl;
+}
+
+// Completion mode needs these opcodes and a provided buffer ring (5.19); multishot
+// recv (6.0) comes with the DEFER_TASKRUN ring this is only tried on
+bool IoUringPoller::setupCompletions() {
+    static const int required[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SENDMSG, IORING_OP_READ,
+                                    IORING_OP_ASYNC_CANCEL, IORING_OP_CLOSE };
+    std::vector<char> probeMemory(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0);
+    struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(&probeMemory[0]);
+    if (syscall(__NR_io_uring_register, _ringFd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(required) / sizeof(required[0]); ++i) {
+        if (required[i] > probe->last_op || !(probe->ops[required[i]].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+
+    _bufRingSize = IOURING_RECV_BUFFERS * sizeof(struct io_uring_buf);
+    void* ring = mmap(NULL, _bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = IOURING_RECV_BUFFERS;
+    reg.bgid = IOURING_BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, _ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(ring, _bufRingSize);
+        return false;
+    }
+    _bufRing = static_cast<struct io_uring_buf_ring*>(ring);
+    _recvBuffers.resize(static_cast<size_t>(IOURING_RECV_BUFFERS) * IOURING_RECV_BUFFER_SIZE);
+    _usedBuffers.reserve(IOURING_RECV_BUFFERS);
+    for (unsigned bid = 0; bid < IOURING_RECV_BUFFERS; ++bid) {
+        provideBuffer(static_cast<unsigned short>(bid));
+    }
+    return true;
+}
+
+// Hand buffer bid back to the ring the kernel picks recv buffers from
+void IoUringPoller::provideBuffer(unsigned short bid) {
+    // Indexed by hand: in C++ the header's flex-array wrapper moves bufs[] off offset 0
+    struct io_uring_buf* buf = reinterpret_cast<struct io_uring_buf*>(_bufRing) + (_bufRingTail & (IOURING_RECV_BUFFERS - 1));
+    buf->addr = reinterpret_cast<uint64_t>(&_recvBuffers[static_cast<size_t>(bid) * IOURING_RECV_BUFFER_SIZE]);
+    buf->len = IOURING_RECV_BUFFER_SIZE;
+    buf->bid = bid; // resv (the ring tail, for the first entry) is left alone
+    ++_bufRingTail;
+    __atomic_store_n(&_bufRing->tail, _bufRingTail, __ATOMIC_RELEASE);
+}
+
+IoUringPoller::~IoUringPoller() {
+    munmap(_sqes, _sqesSize);
+    if (_cqRingPtr != _sqRingPtr) {
+        munmap(_cqRingPtr, _cqRingSize);
+    }
+    munmap(_sqRingPtr, _sqRingSize);
+    if (_ringFd >= 0) {
+        std::cout << "Closing io_uring fd: " << _ringFd << std::endl;
+        close(_ringFd);
+    }
+    if (_bufRing) {
+        munmap(_bufRing, _bufRingSize);
+    }
+}
+
+const char* IoUringPoller::name() const {
+    return "io_uring";
+}
+
+bool IoUringPoller::supportsCompletions() const {
+    return _completions;
+}
+
+IoUringPoller::Registration& IoUringPoller::registration(int fd) {
+    if (static_cast<size_t>(fd) >= _registrations.size()) {
+        _registrations.resize(fd + 1);
+    }
+    return _registrations[fd];
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, int timeoutMs) {
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    if (timeoutMs >= 0) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    return static_cast<int>(syscall(__NR_io_uring_enter, _ringFd, toSubmit, minComplete,
+                                    flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+}
+
+// SQEs queued in the ring that the kernel has not consumed yet
+unsigned IoUringPoller::pendingSubmissions() const {
+    return *_sqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+}
+
+struct io_uring_sqe* IoUringPoller::getSqe() {
+    unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *_sqTail;
+    if (tail - head > *_sqRingMask) {
+        // Ring full: push what we have to the kernel before queueing more
+        if (enter(pendingSubmissions(), 0, 0, -1) < 0) {
+            perror("io_uring_enter(submit) failed");
+            return NULL;
+        }
+        head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+        if (tail - head > *_sqRingMask) {
+            return NULL;
+        }
+    }
+    unsigned index = tail & *_sqRingMask;
+    struct io_uring_sqe* sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sqArray[index] = index;
+    __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+void IoUringPoller::queuePollAdd(int fd) {
+    Registration& reg = registration(fd);
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring: submission queue full, cannot poll fd=" << fd << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = reg.events;
+    sqe->user_data = pollUserData(fd, reg.generation);
+    reg.armed = true;
+}
+
+void IoUringPoller::queuePollRemove(int fd) {
+    Registration& reg = registration(fd);
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring: submission queue full, cannot cancel poll on fd=" << fd << std::endl;
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = pollUserData(fd, reg.generation); // Target the in-flight POLL_ADD
+    sqe->user_data = IOURING_IGNORE_TAG;
+    reg.armed = false;
+}
+
+void IoUringPoller::add(int fd, uint32_t events, EventHandler* handler) {
+    if (fd < 0) {
+        throw std::runtime_error("Failed to add socket to io_uring (invalid fd)");
+    }
+    if (events & EPOLLEXCLUSIVE) {
+        // Every process polling a shared listener would be woken: the thundering herd is back
+        throw std::runtime_error("io_uring backend does not support EPOLLEXCLUSIVE");
+    }
+    Registration& reg = registration(fd);
+    if (reg.armed) {
+        queuePollRemove(fd); // Leftover poll from a previous owner of this fd number
+    }
+    reg.handler = handler;
+    reg.events = events & (POLLIN | POLLOUT | POLLPRI | POLLRDHUP);
+    reg.active = true;
+    ++reg.generation;
+    queuePollAdd(fd);
+}
+
+bool IoUringPoller::modify(int fd, uint32_t events, EventHandler* handler) {
+    if (fd < 0 || static_cast<size_t>(fd) >= _registrations.size() || !_registrations[fd].active) {
+        std::cerr << "io_uring: modify on unregistered fd=" << fd << std::endl;
+        return false;
+    }
+    Registration& reg = _registrations[fd];
+    uint32_t mask = events & (POLLIN | POLLOUT | POLLPRI | POLLRDHUP);
+    reg.handler = handler;
+    if (reg.armed && reg.events == mask) {
+        return true; // Same interest, the in-flight poll still applies
+    }
+    if (reg.armed) {
+        queuePollRemove(fd);
+    }
+    reg.events = mask;
+    ++reg.generation;
+    queuePollAdd(fd);
+    return true;
+}
+
+void IoUringPoller::remove(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= _registrations.size()) {
+        return;
+    }
+    Registration& reg = _registrations[fd];
+    if (reg.armed) {
+        queuePollRemove(fd);
+    }
+    reg.active = false;
+    reg.handler = NULL;
+    ++reg.generation; // Any completion still in flight is now stale
+}
+
+struct io_uring_sqe* IoUringPoller::queueOperation(int opcode, int fd, EventHandler* handler, PollerOp op) {
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring: submission queue full, cannot queue I/O on fd=" << fd << std::endl;
+        return NULL;
+    }
+    sqe->opcode = static_cast<uint8_t>(opcode);
+    sqe->fd = fd;
+    sqe->user_data = reinterpret_cast<uintptr_t>(handler) | static_cast<uint64_t>(op - POLLER_ACCEPT);
+    return sqe;
+}
+
+bool IoUringPoller::acceptMultishot(int listenerFd, EventHandler* handler) {
+    struct io_uring_sqe* sqe = queueOperation(IORING_OP_ACCEPT, listenerFd, handler, POLLER_ACCEPT);
+    if (!sqe) {
+        return false;
+    }
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT; // No peer address: one SQE serves every connection
+    sqe->accept_flags = SOCK_CLOEXEC;      // Blocking is fine, the ring never waits on the socket
+    return true;
+}
+
+bool IoUringPoller::recvMultishot(int fd, EventHandler* handler) {
+    struct io_uring_sqe* sqe = queueOperation(IORING_OP_RECV, fd, handler, POLLER_RECV);
+    if (!sqe) {
+        return false;
+    }
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT; // A provided buffer is picked only once data is there
+    sqe->buf_group = IOURING_BUFFER_GROUP;
+    return true;
+}
+
+bool IoUringPoller::sendMsg(int fd, const struct msghdr* msg, int flags, EventHandler* handler) {
+    struct io_uring_sqe* sqe = queueOperation(IORING_OP_SENDMSG, fd, handler, POLLER_SEND);
+    if (!sqe) {
+        return false;
+    }
+    sqe->addr = reinterpret_cast<uintptr_t>(msg);
+    sqe->len = 1;
+    sqe->msg_flags = static_cast<uint32_t>(flags);
+    return true;
+}
+
+bool IoUringPoller::read(int fd, void* buffer, size_t length, off_t offset, EventHandler* handler) {
+    struct io_uring_sqe* sqe = queueOperation(IORING_OP_READ, fd, handler, POLLER_READ);
+    if (!sqe) {
+        return false;
+    }
+    sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->off = static_cast<uint64_t>(offset);
+    return true;
+}
+
+bool IoUringPoller::queueCancel(int fd, unsigned char sqeFlags) {
+    struct io_uring_sqe* sqe = getSqe();
+    if (!sqe) {
+        std::cerr << "io_uring: submission queue full, cannot cancel I/O on fd=" << fd << std::endl;
+        return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->flags = sqeFlags;
+    sqe->user_data = IOURING_IGNORE_TAG;
+    return true;
+}
+
+void IoUringPoller::cancel(int fd) {
+    if (queueCancel(fd, 0) && enter(pendingSubmissions(), 0, 0, -1) < 0) {
+        perror("io_uring_enter(cancel) failed");
+    }
+}
+
+void IoUringPoller::cancelAndClose(int fd) {
+    // Cancel and close are hard-linked, so both must go in the same submission
+    if (*_sqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) + 2 > *_sqRingMask + 1) {
+        enter(pendingSubmissions(), 0, 0, -1);
+    }
+    struct io_uring_sqe* sqe = NULL;
+    if (queueCancel(fd, IOSQE_IO_HARDLINK | IOSQE_CQE_SKIP_SUCCESS)) {
+        sqe = getSqe();
+    }
+    if (!sqe) {
+        shutdown(fd, SHUT_RDWR); // Completes whatever is still in flight on the socket
+        close(fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = IOURING_IGNORE_TAG;
+}
+
+int IoUringPoller::wait(PollerEvent* events, int maxEvents, int timeoutMs) {
+    // The recv buffers the previous events pointed into go back to the kernel
+    for (size_t i = 0; i < _usedBuffers.size(); ++i) {
+        provideBuffer(_usedBuffers[i]);
+    }
+    _usedBuffers.clear();
+
+    // Re-arm the one-shot polls that fired last round (if still wanted)
+    for (size_t i = 0; i < _rearm.size(); ++i) {
+        Registration& reg = _registrations[_rearm[i]];
+        if (reg.active && !reg.armed) {
+            queuePollAdd(_rearm[i]);
+        }
+    }
+    _rearm.clear();
+
+    // One syscall submits every queued change and waits for readiness
+    unsigned head = *_cqHead;
+    if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) {
+        if (enter(pendingSubmissions(), 1, IORING_ENTER_GETEVENTS, timeoutMs) < 0) {
+            if (errno == ETIME) {
+                return 0; // Timed out
+            }
+            return -1;
+        }
+    } else if (pendingSubmissions() > 0) {
+        if (enter(pendingSubmissions(), 0, 0, -1) < 0) {
+            return -1;
+        }
+    }
+
+    int numEvents = 0;
+    unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail && numEvents < maxEvents) {
+        const struct io_uring_cqe& cqe = _cqes[head & *_cqRingMask];
+        ++head;
+        if (cqe.user_data == IOURING_IGNORE_TAG) {
+            continue;
+        }
+        if (!(cqe.user_data & IOURING_POLL_TAG)) {
+            PollerEvent& event = events[numEvents++];
+            event.handler = reinterpret_cast<EventHandler*>(static_cast<uintptr_t>(cqe.user_data & ~IOURING_OP_MASK));
+            event.events = 0;
+            event.op = static_cast<PollerOp>(POLLER_ACCEPT + (cqe.user_data & IOURING_OP_MASK));
+            event.result = cqe.res;
+            event.data = NULL;
+            event.more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                unsigned short bid = static_cast<unsigned short>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                event.data = &_recvBuffers[static_cast<size_t>(bid) * IOURING_RECV_BUFFER_SIZE];
+                _usedBuffers.push_back(bid);
+            }
+            continue;
+        }
+        int fd = static_cast<int>((cqe.user_data & ~IOURING_POLL_TAG) >> 32);
+        uint32_t generation = static_cast<uint32_t>(cqe.user_data);
+        if (static_cast<size_t>(fd) >= _registrations.size()) {
+            continue;
+        }
+        Registration& reg = _registrations[fd];
+        if (!reg.active || reg.generation != generation) {
+            continue; // Completion for a removed or re-registered poll
+        }
+        reg.armed = false;
+        _rearm.push_back(fd);
+        if (cqe.res == -ECANCELED) {
+            continue;
+        }
+        events[numEvents].handler = reg.handler;
+        events[numEvents].events = cqe.res < 0 ? static_cast<uint32_t>(EPOLLERR) : static_cast<uint32_t>(cqe.res);
+        events[numEvents].op = POLLER_READY;
+        events[numEvents].result = 0;
+        events[numEvents].data = NULL;
+        events[numEvents].more = false;
+        ++numEvents;
+    }
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    return numEvents;
+}
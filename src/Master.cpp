@@ -0,0 +1,220 @@
+#include "Master.hpp"
+#include "Server.hpp"
+#include "Upgrade.hpp"
+#include <iostream>
+#include <unistd.h>   // for fork, _exit, sleep
+#include <sys/wait.h> // for waitpid
+#include <cerrno>     // for errno
+#include <cstdio>     // for perror
+#include <cstring>    // for memset, strsignal
+#include <ctime>      // for time
+
+volatile sig_atomic_t Master::_stopRequested = 0;
+volatile sig_atomic_t Master::_drainRequested = 0;
+volatile sig_atomic_t Master::_upgradeRequested = 0;
+
+Master::Master(const Config& config) : _config(config), _newBinary(-1) {
+    std::cout << "Master process created (pid=" << getpid() << ")." << std::endl;
+}
+
+Master::~Master() {
+    // Listening sockets are closed by their destructors
+    std::cout << "Master process destroyed." << std::endl;
+}
+
+void Master::signalHandler(int signum) {
+    if (signum == SIGQUIT) {
+        _drainRequested = 1;
+    } else if (signum == SIGUSR2) {
+        _upgradeRequested = 1;
+    } else {
+        _stopRequested = 1;
+    }
+}
+
+void Master::installSignalHandlers() {
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = Master::signalHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0; // No SA_RESTART: waitpid must return EINTR so the loop sees the flag
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGQUIT, &sa, NULL); // Graceful: workers drain their connections first
+    sigaction(SIGUSR2, &sa, NULL); // Binary upgrade
+}
+
+bool Master::bindListeners() {
+    std::vector<std::pair<std::string, int> > listeners = _config.getListeners();
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        std::cout << "Master binding listener on " << listeners[i].first << ":" << listeners[i].second << std::endl;
+        Socket listener(listeners[i].second);
+        // After a binary upgrade the old master's listener is adopted instead of re-bound
+        int inheritedFd = Upgrade::claimListener(listeners[i].first, listeners[i].second);
+        bool ready = inheritedFd >= 0 ? listener.adopt(inheritedFd) : listener.init(listeners[i].first);
+        if (!ready) {
+            std::cerr << "Failed to initialize listener socket on " << listeners[i].first << ":" << listeners[i].second << std::endl;
+            return false;
+        }
+        _listeningSockets.emplace_back(std::move(listener));
+    }
+    Upgrade::closeUnclaimedListeners();
+    return true;
+}
+
+pid_t Master::spawnWorker(size_t slot) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        return -1;
+    }
+    if (pid == 0) {
+        // Child: default signal dispositions, then run a normal event loop on the inherited listeners
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        Server::installSignalHandlers(false); // SIGQUIT drains; SIGUSR2 is the master's
+        std::vector<int> listenerFds;
+        for (size_t i = 0; i < _listeningSockets.size(); ++i) {
+            listenerFds.push_back(_listeningSockets[i].getFd());
+        }
+        int status = 0;
+        try {
+            Server server(_config, listenerFds);
+            server.run();
+        } catch (const std::exception& e) {
+            std::cerr << "Worker " << slot << " (pid=" << getpid() << ") error: " << e.what() << std::endl;
+            status = 1;
+        }
+        // _exit: don't run the master's destructors/atexit handlers in the child
+        _exit(status);
+    }
+    std::cout << "Spawned worker " << slot << " (pid=" << pid << ")." << std::endl;
+    return pid;
+}
+
+void Master::run() {
+    if (!bindListeners()) {
+        std::cerr << "Master failed to bind listeners. Aborting." << std::endl;
+        return;
+    }
+    installSignalHandlers();
+
+    _workers.assign(_config.getWorkerProcesses(), -1);
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        _workers[i] = spawnWorker(i);
+    }
+
+    Upgrade::retireParent(); // Started by a binary upgrade: the old master can drain now
+
+    superviseWorkers();
+    if (_drainRequested && !_stopRequested) {
+        drainWorkers();
+    } else {
+        stopWorkers();
+    }
+}
+
+// Reap workers and respawn the ones that crashed or exited unexpectedly
+void Master::superviseWorkers() {
+    time_t lastRespawn = 0;
+
+    while (!_stopRequested && !_drainRequested) {
+        if (_upgradeRequested) {
+            _upgradeRequested = 0;
+            if (_newBinary > 0) {
+                std::cerr << "Binary upgrade already in progress (pid=" << _newBinary << ")." << std::endl;
+            } else {
+                std::vector<int> listenerFds;
+                for (size_t i = 0; i < _listeningSockets.size(); ++i) {
+                    listenerFds.push_back(_listeningSockets[i].getFd());
+                }
+                // The new master sends us SIGQUIT once its workers are up
+                _newBinary = Upgrade::spawnNewBinary(listenerFds);
+            }
+        }
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue; // Signal received, re-check _stopRequested
+            }
+            if (errno == ECHILD) {
+                // Every fork failed; back off and try again below
+                sleep(1);
+            } else {
+                perror("waitpid failed");
+                break;
+            }
+        }
+
+        if (pid > 0 && pid == _newBinary) {
+            // Upgrade failed (bad binary or config): keep serving with this one
+            std::cerr << "New binary (pid=" << pid << ") exited before taking over; upgrade aborted." << std::endl;
+            _newBinary = -1;
+            continue;
+        }
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            if (pid > 0 && _workers[i] == pid) {
+                if (WIFSIGNALED(status)) {
+                    std::cerr << "Worker " << i << " (pid=" << pid << ") killed by signal "
+                              << WTERMSIG(status) << " (" << strsignal(WTERMSIG(status)) << ")." << std::endl;
+                } else {
+                    std::cerr << "Worker " << i << " (pid=" << pid << ") exited with status "
+                              << WEXITSTATUS(status) << "." << std::endl;
+                }
+                _workers[i] = -1;
+            }
+        }
+
+        // Throttle respawns so a worker crashing at startup can't fork-bomb the box
+        if (time(0) == lastRespawn) {
+            sleep(1);
+        }
+        for (size_t i = 0; i < _workers.size() && !_stopRequested && !_drainRequested; ++i) {
+            if (_workers[i] < 0) {
+                _workers[i] = spawnWorker(i);
+                lastRespawn = time(0);
+            }
+        }
+    }
+}
+
+void Master::stopWorkers() {
+    std::cout << "Master stopping workers..." << std::endl;
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        if (_workers[i] > 0) {
+            kill(_workers[i], SIGTERM);
+        }
+    }
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        if (_workers[i] > 0) {
+            waitpid(_workers[i], NULL, 0);
+            _workers[i] = -1;
+        }
+    }
+}
+
+// Graceful shutdown (SIGQUIT, e.g. from the binary that replaced us):
+// workers stop accepting and exit once their last connection is done.
+void Master::drainWorkers() {
+    std::cout << "Master draining workers..." << std::endl;
+    _listeningSockets.clear(); // The workers (and the new binary) hold their own copies
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        if (_workers[i] > 0) {
+            kill(_workers[i], SIGQUIT);
+        }
+    }
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        if (_workers[i] <= 0) {
+            continue;
+        }
+        while (waitpid(_workers[i], NULL, 0) < 0 && errno == EINTR) {
+            if (_stopRequested) {
+                kill(_workers[i], SIGTERM); // Impatient operator: stop draining
+            }
+        }
+        _workers[i] = -1;
+    }
+    std::cout << "All workers drained." << std::endl;
+}
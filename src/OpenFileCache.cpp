@@ -0,0 +1,178 @@
+#include "OpenFileCache.hpp"
+#include <iostream>
+#include <cstdio>   // For perror
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h> // For read, close
+
+// Anything that can change what a path resolves to
+#define WATCH_MASK (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE \
+                    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+// "a/b/c" and "a/b/c/" -> "a/b"
+static std::string parentOf(const std::string& path) {
+    std::string::size_type end = path.find_last_not_of('/');
+    if (end == std::string::npos) {
+        return "/";
+    }
+    std::string::size_type slash = path.rfind('/', end);
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+static std::string withoutTrailingSlash(const std::string& path) {
+    std::string::size_type end = path.find_last_not_of('/');
+    return end == std::string::npos ? "/" : path.substr(0, end + 1);
+}
+
+OpenFileCache::OpenFileCache(size_t maxEntries, unsigned long validMs) :
+    EventHandler(FILE_CACHE),
+    _maxEntries(maxEntries),
+    _validMs(validMs),
+    _inotifyFd(-1),
+    _hits(0),
+    _misses(0)
+{
+    if (_maxEntries == 0) {
+        return; // open_file_cache off
+    }
+    _index.reserve(_maxEntries);
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotifyFd < 0) {
+        perror("inotify_init1 failed, open_file_cache entries will only expire by age");
+    }
+}
+
+OpenFileCache::~OpenFileCache() {
+    if (_inotifyFd >= 0) {
+        close(_inotifyFd);
+    }
+}
+
+bool OpenFileCache::isEnabled() const { return _maxEntries > 0; }
+int OpenFileCache::getWatchFd() const { return _inotifyFd; }
+size_t OpenFileCache::size() const { return _lru.size(); }
+unsigned long OpenFileCache::getHits() const { return _hits; }
+unsigned long OpenFileCache::getMisses() const { return _misses; }
+
+const FileLookup* OpenFileCache::find(const std::string& path, uint64_t nowMs) {
+    if (!isEnabled()) {
+        return NULL;
+    }
+    std::unordered_map<std::string, EntryList::iterator>::iterator it = _index.find(path);
+    if (it == _index.end()) {
+        ++_misses;
+        return NULL;
+    }
+    if (nowMs >= it->second->expiresMs) {
+        _lru.erase(it->second);
+        _index.erase(it);
+        ++_misses;
+        return NULL;
+    }
+    _lru.splice(_lru.begin(), _lru, it->second); // Most recently used
+    ++_hits;
+    return &_lru.front().result;
+}
+
+void OpenFileCache::insert(const std::string& path, const FileLookup& result, uint64_t nowMs) {
+    if (!isEnabled()) {
+        return;
+    }
+    invalidate(path);
+    // Watch where the path lives; a directory also for its index files
+    watchDirectory(parentOf(path));
+    if (result.isDirectory) {
+        watchDirectory(withoutTrailingSlash(path));
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.result = result;
+    entry.expiresMs = nowMs + _validMs;
+    _lru.push_front(entry);
+    _index[path] = _lru.begin();
+
+    while (_lru.size() > _maxEntries) {
+        _index.erase(_lru.back().path);
+        _lru.pop_back(); // Closes the file unless a queued response still sends from it
+    }
+}
+
+void OpenFileCache::watchDirectory(const std::string& dir) {
+    if (_inotifyFd < 0 || _watchedPaths.count(dir)) {
+        return;
+    }
+    int wd = inotify_add_watch(_inotifyFd, dir.c_str(), WATCH_MASK | IN_ONLYDIR);
+    if (wd < 0) {
+        // Missing directory (negative entry) or out of watches: the TTL still applies
+        return;
+    }
+    _watchDirs[wd] = dir;
+    _watchedPaths[dir] = wd;
+}
+
+void OpenFileCache::invalidate(const std::string& path) {
+    std::unordered_map<std::string, EntryList::iterator>::iterator it = _index.find(path);
+    if (it != _index.end()) {
+        _lru.erase(it->second);
+        _index.erase(it);
+    }
+}
+
+// Something named name changed in dir: drop it (as file or directory) and dir
+// itself, whose index-file resolution may have changed
+void OpenFileCache::invalidateDirectory(const std::string& dir, const std::string& name) {
+    if (!name.empty()) {
+        std::string path = (dir == "/" ? "" : dir) + "/" + name;
+        invalidate(path);
+        invalidate(path + "/");
+    }
+    invalidate(dir);
+    invalidate(dir + "/");
+}
+
+void OpenFileCache::clear() {
+    _lru.clear();
+    _index.clear();
+}
+
+void OpenFileCache::processEvents() {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (true) {
+        ssize_t length = read(_inotifyFd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            break; // EAGAIN: drained
+        }
+        for (char* p = buffer; p < buffer + length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                std::cerr << "open_file_cache: inotify queue overflowed, flushing " << _lru.size() << " entries." << std::endl;
+                clear();
+                continue;
+            }
+            std::map<int, std::string>::iterator watch = _watchDirs.find(event->wd);
+            if (watch == _watchDirs.end()) {
+                continue;
+            }
+            const std::string dir = watch->second;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                // The directory itself went away: everything below it is suspect
+                clear();
+                if (event->mask & IN_IGNORED) {
+                    _watchedPaths.erase(dir);
+                    _watchDirs.erase(watch);
+                }
+                continue;
+            }
+            invalidateDirectory(dir, event->len > 0 ? std::string(event->name) : std::string());
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#include "Poller.hpp"
+#include "EpollPoller.hpp"
+#include "IoUringPoller.hpp"
+#include <iostream>
+#include <stdexcept> // For runtime_error
+
+Poller* Poller::create(const std::string& backend) {
+    if (backend == "io_uring") {
+        try {
+            return new IoUringPoller();
+        } catch (const std::exception& e) {
+            std::cerr << "io_uring backend unavailable (" << e.what() << "), falling back to epoll." << std::endl;
+        }
+    } else if (backend != "epoll") {
+        throw std::runtime_error("Unknown event backend: " + backend);
+    }
+    return new EpollPoller();
+}
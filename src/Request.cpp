@@ -1,126 +1,537 @@
 #include "Request.hpp"
+#include "CharScan.hpp"
 #include <iostream> // Example include
-#include <sstream>
-#include <algorithm> // for std::transform (lowercase header keys)
+#include <cstring>  // For strncmp, memset
+#include <strings.h> // For strncasecmp
+#include <cctype>  // For isxdigit
+#include <algorithm> // For std::min
 
-Request::Request() {
-    // Constructor implementation
+Request::Request() :
+    _buffer(NULL),
+    _state(ParsingRequestLine),
+    _errorCode(0),
+    _scanOffset(0),
+    _lineStart(0),
+    _headStart(0),
+    _bodyStart(0),
+    _contentLength(0),
+    _requestLength(0),
+    _chunked(false),
+    _chunkState(ChunkSize),
+    _chunkRemaining(0),
+    _trailerBytes(0),
+    _bodyEnd(0),
+    _bodyLength(0),
+    _maxBodySize(0),
+    _bodyConsumer(NULL)
+{
+    std::memset(_headerIndex, 0, sizeof(_headerIndex));
 }
 
+void Request::reset() {
+    _buffer = NULL;
+    _state = ParsingRequestLine;
+    _errorCode = 0;
+    _scanOffset = 0;
+    _lineStart = 0;
+    _headStart = 0;
+    _method = Span();
+    _path = Span();
+    _version = Span();
+    _headers.clear();
+    std::memset(_headerIndex, 0, sizeof(_headerIndex));
+    _bodyStart = 0;
+    _contentLength = 0;
+    _requestLength = 0;
+    _chunked = false;
+    _chunkState = ChunkSize;
+    _chunkRemaining = 0;
+    _trailerBytes = 0;
+    _bodyEnd = 0;
+    _bodyLength = 0;
+}
+
+void Request::setMaxBodySize(size_t bytes) { _maxBodySize = bytes; }
+void Request::setBodyConsumer(BodyConsumer* consumer) { _bodyConsumer = consumer; }
+
 Request::~Request() {
     // Destructor implementation
 }
 
-// Basic placeholder parsing. Real implementation needs robust error handling,
-// state management for partial requests, header parsing, body handling (Content-Length).
-bool Request::parse(const std::string& rawRequest) {
-    std::cout << "--- Parsing Request --- (Placeholder)\n" << rawRequest.substr(0, 100) << "...\n--- End Request Preview ---" << std::endl;
+// Incremental parse: every byte is examined once, however many recv() calls the
+// request is split over. Lines are located from _scanOffset and validated with
+// the vectorized CharScan kernels; the request line and headers are recorded as
+// offsets, nothing is copied. Body bytes are then decoded as they arrive.
+Request::ParseState Request::parse(std::string& buffer) {
+    _buffer = &buffer;
+    const char* data = buffer.data();
+    size_t size = buffer.size();
+
+    while (_state == ParsingRequestLine || _state == ParsingHeaders) {
+        const char* newline = CharScan::findLineEnd(data + _scanOffset, data + size);
+        if (newline == data + size) {
+            _scanOffset = size;
+            // Reject oversized heads as soon as the limit is crossed, not when the line finally ends
+            if (_state == ParsingRequestLine && size - _lineStart > MAX_REQUEST_LINE) {
+                return fail(414);
+            }
+            if (_state == ParsingHeaders && size - _headStart > MAX_REQUEST_HEAD) {
+                return fail(431);
+            }
+            return _state;
+        }
+
+        size_t lineEnd = newline - data; // Index of '\n'
+        _scanOffset = lineEnd + 1;
+        size_t contentEnd = (lineEnd > _lineStart && data[lineEnd - 1] == '\r') ? lineEnd - 1 : lineEnd;
+
+        if (_state == ParsingRequestLine) {
+            if (contentEnd == _lineStart) {
+                // Blank line(s) before the request line are ignored (RFC 9112 section 2.2)
+                _lineStart = _scanOffset;
+                _headStart = _scanOffset;
+                continue;
+            }
+            if (contentEnd - _lineStart > MAX_REQUEST_LINE) {
+                return fail(414);
+            }
+            if (!parseRequestLine(contentEnd)) {
+                return _state;
+            }
+            _state = ParsingHeaders;
+        } else if (_scanOffset - _headStart > MAX_REQUEST_HEAD) {
+            return fail(431);
+        } else if (contentEnd == _lineStart) {
+            // Empty line: end of the head
+            _bodyStart = _scanOffset;
+            if (!finishHeaders()) {
+                return _state;
+            }
+        } else if (!parseHeaderLine(contentEnd)) {
+            return _state;
+        }
+        _lineStart = _scanOffset;
+    }
 
-    size_t headers_end = rawRequest.find("\r\n\r\n");
-    if (headers_end == std::string::npos) {
-        std::cerr << "Request::parse: Headers end (\\r\\n\\r\\n) not found." << std::endl;
-        return false; // Not a complete request yet
+    if (_state == ParsingBody) {
+        parseBody(buffer);
     }
+    return _state;
+}
+
+// Decode whatever body bytes are buffered. Data is handed to the body consumer or
+// moved down to _bodyEnd; chunk framing never leaves the raw region, which
+// compactBody() then cuts out of the buffer.
+void Request::parseBody(std::string& buffer) {
+    char* data = &buffer[0];
+    size_t size = buffer.size();
 
-    std::string request_line_end = rawRequest.substr(0, headers_end);
-    std::istringstream requestStream(request_line_end);
-    std::string line;
+    if (!_chunked) {
+        size_t available = std::min(size - _lineStart, _contentLength - _bodyLength);
+        if (available && !deliverBody(data, _lineStart, available)) {
+            return;
+        }
+        _lineStart += available;
+        _scanOffset = _lineStart;
+        if (_bodyLength == _contentLength) {
+            _state = Complete;
+        }
+    }
 
-    // 1. Parse Request Line
-    if (std::getline(requestStream, line) && !line.empty() && line.back() == '\r') {
-         line.pop_back(); // Remove trailing '\r'
-        std::istringstream lineStream(line);
-        if (!(lineStream >> _method >> _path >> _version)) {
-             std::cerr << "Request::parse: Failed to parse request line: " << line << std::endl;
-             // Throw exception or return false?
-             return false; // Indicate parse failure
+    while (_chunked && _state == ParsingBody) {
+        if (_chunkState == ChunkData) {
+            size_t available = std::min(size - _lineStart, _chunkRemaining);
+            if (available == 0) {
+                break;
+            }
+            if (!deliverBody(data, _lineStart, available)) {
+                return;
+            }
+            _lineStart += available;
+            _scanOffset = _lineStart;
+            _chunkRemaining -= available;
+            if (_chunkRemaining == 0) {
+                _chunkState = ChunkDataEnd;
+            }
+            continue;
+        }
+
+        const char* newline = CharScan::findLineEnd(data + _scanOffset, data + size);
+        if (newline == data + size) {
+            _scanOffset = size;
+            size_t pending = size - _lineStart;
+            if (_chunkState == ChunkTrailer && _trailerBytes + pending > MAX_REQUEST_HEAD) {
+                fail(431);
+                return;
+            }
+            if (_chunkState != ChunkTrailer && pending > MAX_CHUNK_LINE) {
+                fail(400);
+                return;
+            }
+            break;
+        }
+        size_t lineEnd = newline - data;
+        _scanOffset = lineEnd + 1;
+        size_t contentEnd = (lineEnd > _lineStart && data[lineEnd - 1] == '\r') ? lineEnd - 1 : lineEnd;
+        if (!parseChunkLine(contentEnd)) {
+            return;
+        }
+        _lineStart = _scanOffset;
+    }
+
+    compactBody(buffer);
+    if (_state == Complete) {
+        _requestLength = _lineStart;
+        if (_bodyLength > 0 || _chunked) {
+            std::cout << "Request body complete: " << _bodyLength << " bytes" << (_chunked ? " (chunked)" : "") << std::endl;
+        }
+    }
+}
+
+// One line of chunked framing: chunk-size [ chunk-ext ], the CRLF after chunk-data,
+// or a trailer field line (RFC 9112 section 7.1)
+bool Request::parseChunkLine(size_t lineEnd) {
+    const char* data = _buffer->data();
+
+    if (_chunkState == ChunkDataEnd) {
+        if (lineEnd != _lineStart) {
+            fail(400); // Chunk data longer than its size
+            return false;
+        }
+        _chunkState = ChunkSize;
+        return true;
+    }
+
+    if (_chunkState == ChunkTrailer) {
+        if (lineEnd == _lineStart) {
+            _state = Complete; // Empty line ends the trailer section
+            return true;
+        }
+        _trailerBytes += _scanOffset - _lineStart;
+        if (_trailerBytes > MAX_REQUEST_HEAD) {
+            fail(431);
+            return false;
+        }
+        // Trailer fields are validated but not merged into the headers (RFC 9112 section 7.1.2)
+        HeaderField trailer;
+        return parseFieldLine(lineEnd, trailer);
+    }
+
+    if (lineEnd - _lineStart > MAX_CHUNK_LINE) {
+        fail(400);
+        return false;
+    }
+    size_t pos = _lineStart;
+    size_t chunkSize = 0;
+    while (pos < lineEnd && std::isxdigit(static_cast<unsigned char>(data[pos]))) {
+        if (pos - _lineStart == 15) {
+            fail(400); // Chunk size does not fit
+            return false;
+        }
+        char c = data[pos++];
+        chunkSize = chunkSize * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    if (pos == _lineStart) {
+        fail(400);
+        return false;
+    }
+    // Chunk extensions (BWS ";" ...) carry nothing we use: only check there's no garbage
+    while (pos < lineEnd && (data[pos] == ' ' || data[pos] == '\t')) ++pos;
+    if (pos < lineEnd && (data[pos] != ';'
+        || CharScan::skipFieldValueChars(data + pos, data + lineEnd) != data + lineEnd)) {
+        fail(400);
+        return false;
+    }
+
+    if (chunkSize == 0) {
+        _chunkState = ChunkTrailer; // last-chunk
+    } else if (_maxBodySize && _bodyLength + chunkSize > _maxBodySize) {
+        fail(413); // Refuse before the chunk data arrives
+        return false;
+    } else {
+        _chunkRemaining = chunkSize;
+        _chunkState = ChunkData;
+    }
+    return true;
+}
+
+// Hand decoded body bytes at offset to the consumer, or move them down to _bodyEnd
+bool Request::deliverBody(char* data, size_t offset, size_t length) {
+    if (_maxBodySize && _bodyLength + length > _maxBodySize) {
+        fail(413);
+        return false;
+    }
+    if (_bodyConsumer) {
+        if (!_bodyConsumer->consume(data + offset, length)) {
+            fail(500);
+            return false;
         }
-        std::cout << "Parsed Request Line: Method=" << _method << ", Path=" << _path << ", Version=" << _version << std::endl;
     } else {
-         std::cerr << "Request::parse: Invalid or empty request line." << std::endl;
+        if (offset != _bodyEnd) {
+            std::memmove(data + _bodyEnd, data + offset, length);
+        }
+        _bodyEnd += length;
+    }
+    _bodyLength += length;
+    return true;
+}
+
+// Cut the consumed raw bytes (framing, or data given to the consumer) out of the
+// buffer. What remains after them is at most a partial line or pipelined requests.
+void Request::compactBody(std::string& buffer) {
+    size_t gap = _lineStart - _bodyEnd;
+    if (gap == 0) {
+        return;
+    }
+    buffer.erase(_bodyEnd, gap);
+    _lineStart -= gap;
+    _scanOffset -= gap;
+}
+
+Request::ParseState Request::fail(int errorCode) {
+    std::cerr << "Request::parse: rejecting request with " << errorCode << "." << std::endl;
+    _errorCode = errorCode;
+    _state = Error;
+    return _state;
+}
+
+// method SP request-target SP HTTP-version
+bool Request::parseRequestLine(size_t lineEnd) {
+    const char* data = _buffer->data();
+    size_t pos = _lineStart;
+
+    pos = CharScan::skipTokenChars(data + pos, data + lineEnd) - data;
+    if (pos == _lineStart || pos >= lineEnd || data[pos] != ' ') {
+        fail(400);
         return false;
     }
+    _method = Span(_lineStart, pos - _lineStart);
 
-    // 2. Parse Headers (Simplified)
-    _headers.clear();
-    while (std::getline(requestStream, line) && !line.empty() && line.back() == '\r') {
-         line.pop_back(); // Remove trailing '\r'
-         if (line.empty()) break; // End of headers (should be handled by find("\r\n\r\n") but good safety)
-
-        size_t colon_pos = line.find(':');
-        if (colon_pos != std::string::npos) {
-            std::string key = line.substr(0, colon_pos);
-            std::string value = line.substr(colon_pos + 1);
-            // Trim whitespace from value
-            value.erase(0, value.find_first_not_of(" \t"));
-            value.erase(value.find_last_not_of(" \t") + 1);
-            // Store header (consider lowercase key for case-insensitivity)
-            std::string lowerKey = key;
-            std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(), ::tolower);
-            _headers[lowerKey] = value;
-             // std::cout << "Parsed Header: " << lowerKey << ": " << value << std::endl;
-        } else {
-             std::cerr << "Request::parse: Malformed header line: " << line << std::endl;
-             // Ignore malformed header? Or fail request? For now, ignore.
-        }
-    }
-
-    // 3. TODO: Handle Body based on Content-Length or Transfer-Encoding (Chunked)
-    // For basic GET, body is usually empty.
-    size_t body_start = headers_end + 4; // Start after \r\n\r\n
-    if (body_start < rawRequest.length()) {
-        // Check Content-Length header
-         std::map<std::string, std::string>::const_iterator cl_it = _headers.find("content-length");
-        if (cl_it != _headers.end()) {
-             try {
-                size_t contentLength = std::stoul(cl_it->second);
-                 if (rawRequest.length() >= body_start + contentLength) {
-                    _body = rawRequest.substr(body_start, contentLength);
-                     std::cout << "Parsed Body (" << contentLength << " bytes)." << std::endl;
-                 } else {
-                      std::cerr << "Request::parse: Incomplete body. Expected " << contentLength << ", got " << (rawRequest.length() - body_start) << std::endl;
-                     return false; // Body not fully received yet
-                 }
-             } catch (...) {
-                 std::cerr << "Request::parse: Invalid Content-Length: " << cl_it->second << std::endl;
-                 return false; // Bad Request
-             }
-        }
-        // TODO: Handle chunked transfer encoding
-    }
-
-
-    return true; // Parsing successful (for headers at least)
+    size_t targetStart = ++pos;
+    pos = CharScan::skipTargetChars(data + pos, data + lineEnd) - data;
+    if (pos == targetStart || pos >= lineEnd || data[pos] != ' ') {
+        fail(400);
+        return false;
+    }
+    _path = Span(targetStart, pos - targetStart);
+
+    size_t versionStart = ++pos;
+    _version = Span(versionStart, lineEnd - versionStart);
+    if (_version.length != 8 || std::strncmp(data + versionStart, "HTTP/", 5) != 0
+        || data[versionStart + 5] < '0' || data[versionStart + 5] > '9'
+        || data[versionStart + 6] != '.'
+        || data[versionStart + 7] < '0' || data[versionStart + 7] > '9') {
+        fail(400);
+        return false;
+    }
+    if (data[versionStart + 5] != '1') {
+        fail(505); // HTTP Version Not Supported
+        return false;
+    }
+    std::cout << "Parsed Request Line: Method=" << spanToString(_method) << ", Path=" << spanToString(_path)
+              << ", Version=" << spanToString(_version) << std::endl;
+    return true;
+}
+
+// Header line: stored in _headers and indexed by id
+bool Request::parseHeaderLine(size_t lineEnd) {
+    if (_headers.size() >= MAX_REQUEST_HEADERS) {
+        fail(431);
+        return false;
+    }
+    HeaderField field;
+    if (!parseFieldLine(lineEnd, field)) {
+        return false;
+    }
+    if (_headers.empty()) {
+        _headers.reserve(16); // Typical browser request; grows at most a few times
+    }
+    _headers.push_back(field);
+    if (field.id != HEADER_UNKNOWN && !_headerIndex[field.id]) {
+        _headerIndex[field.id] = static_cast<unsigned char>(_headers.size());
+    }
+    return true;
 }
 
+// field-name ":" OWS field-value OWS (header or trailer line)
+bool Request::parseFieldLine(size_t lineEnd, HeaderField& field) {
+    const char* data = _buffer->data();
+    size_t pos = _lineStart;
+
+    if (data[pos] == ' ' || data[pos] == '\t') {
+        fail(400); // Obsolete line folding
+        return false;
+    }
+    pos = CharScan::skipTokenChars(data + pos, data + lineEnd) - data;
+    if (pos == _lineStart || pos >= lineEnd || data[pos] != ':') {
+        fail(400); // Empty name, or whitespace before the colon
+        return false;
+    }
+    field.name = Span(_lineStart, pos - _lineStart);
+    field.id = KnownHeaders::lookup(data + _lineStart, field.name.length);
+
+    size_t valueStart = pos + 1;
+    size_t valueEnd = lineEnd;
+    while (valueStart < valueEnd && (data[valueStart] == ' ' || data[valueStart] == '\t')) ++valueStart;
+    if (CharScan::skipFieldValueChars(data + valueStart, data + valueEnd) != data + valueEnd) {
+        fail(400); // Control character (e.g. a bare CR) inside the value
+        return false;
+    }
+    while (valueEnd > valueStart && (data[valueEnd - 1] == ' ' || data[valueEnd - 1] == '\t')) --valueEnd;
+    field.value = Span(valueStart, valueEnd - valueStart);
+    return true;
+}
+
+// Work out the body framing once the head is complete
+bool Request::finishHeaders() {
+    const char* data = _buffer->data();
+
+    _contentLength = 0;
+    _bodyEnd = _bodyStart;
+    _bodyLength = 0;
+
+    const HeaderField* transferEncoding = findHeader(HEADER_TRANSFER_ENCODING);
+    if (transferEncoding) {
+        // RFC 9112 section 6.1: Transfer-Encoding with Content-Length, in HTTP/1.0, or
+        // with a final coding other than chunked leaves the body length unknown (400).
+        // Only plain "chunked" is decoded; any other coding is 501.
+        const char* value = data + transferEncoding->value.offset;
+        size_t length = transferEncoding->value.length;
+        size_t lastStart = length;
+        while (lastStart > 0 && value[lastStart - 1] != ',') --lastStart;
+        while (lastStart < length && (value[lastStart] == ' ' || value[lastStart] == '\t')) ++lastStart;
+        bool chunkedLast = length - lastStart == 7 && strncasecmp(value + lastStart, "chunked", 7) == 0;
+        if (findHeader(HEADER_CONTENT_LENGTH) || data[_version.offset + 7] == '0' || !chunkedLast) {
+            fail(400);
+            return false;
+        }
+        for (size_t i = 0; i < _headers.size(); ++i) {
+            if (_headers[i].id == HEADER_TRANSFER_ENCODING && &_headers[i] != transferEncoding) {
+                fail(501); // Codings spread over several fields
+                return false;
+            }
+        }
+        if (lastStart != 0) {
+            fail(501); // e.g. "gzip, chunked"
+            return false;
+        }
+        _chunked = true;
+        _chunkState = ChunkSize;
+        _state = ParsingBody;
+        return true;
+    }
+
+    bool seen = false;
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        const HeaderField& field = _headers[i];
+        if (field.id != HEADER_CONTENT_LENGTH) {
+            continue;
+        }
+        if (field.value.length == 0 || field.value.length > 18) {
+            fail(400);
+            return false;
+        }
+        size_t length = 0;
+        for (size_t j = 0; j < field.value.length; ++j) {
+            char c = data[field.value.offset + j];
+            if (c < '0' || c > '9') {
+                fail(400);
+                return false;
+            }
+            length = length * 10 + (c - '0');
+        }
+        if (seen && length != _contentLength) {
+            fail(400); // Conflicting Content-Length headers
+            return false;
+        }
+        _contentLength = length;
+        seen = true;
+    }
+    if (_maxBodySize && _contentLength > _maxBodySize) {
+        fail(413); // Refuse before reading any of the body
+        return false;
+    }
+    _state = ParsingBody;
+    return true;
+}
+
+std::string Request::spanToString(const Span& span) const {
+    if (!_buffer) {
+        return "";
+    }
+    return _buffer->substr(span.offset, span.length);
+}
+
+const Request::HeaderField* Request::findHeader(HeaderId id) const {
+    unsigned char position = _headerIndex[id];
+    return position ? &_headers[position - 1] : NULL;
+}
 
 // Accessors
-const std::string& Request::getMethod() const { return _method; }
-const std::string& Request::getPath() const { return _path; }
-const std::string& Request::getVersion() const { return _version; }
-const std::map<std::string, std::string>& Request::getHeaders() const { return _headers; }
-const std::string& Request::getBody() const { return _body; }
+Request::ParseState Request::getState() const { return _state; }
+int Request::getErrorCode() const { return _errorCode; }
+bool Request::hasCompleteHeaders() const { return _state == ParsingBody || _state == Complete; }
+std::string Request::getMethod() const { return spanToString(_method); }
+std::string Request::getPath() const { return spanToString(_path); }
+std::string Request::getVersion() const { return spanToString(_version); }
+const std::vector<Request::HeaderField>& Request::getHeaderFields() const { return _headers; }
+size_t Request::getRequestLength() const { return _requestLength; }
 
-std::string Request::getHeader(const std::string& key) const {
-    std::string lowerKey = key;
-    std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(), ::tolower);
-    std::map<std::string, std::string>::const_iterator it = _headers.find(lowerKey);
-    if (it != _headers.end()) {
-        return it->second;
+size_t Request::getBodyLength() const { return _bodyLength; }
+bool Request::isChunked() const { return _chunked; }
+
+std::string Request::getBody() const {
+    return spanToString(Span(_bodyStart, _state == Complete ? _bodyEnd - _bodyStart : 0));
+}
+
+bool Request::wantsKeepAlive() const {
+    if (_buffer && _version.length == 8 && (*_buffer)[_version.offset + 7] == '1') { // HTTP/1.1
+        return !headerHasToken(HEADER_CONNECTION, "close");
     }
-    return ""; // Return empty string if header not found
+    return headerHasToken(HEADER_CONNECTION, "keep-alive");
 }
 
-// Mutators
-void Request::setMethod(const std::string& method) { _method = method; }
-void Request::setPath(const std::string& path) { _path = path; }
-void Request::setVersion(const std::string& version) { _version = version; }
-void Request::addHeader(const std::string& key, const std::string& value) {
-     std::string lowerKey = key;
-     std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(), ::tolower);
-    _headers[lowerKey] = value;
+bool Request::headerHasToken(HeaderId id, const char* token) const {
+    const HeaderField* field = findHeader(id);
+    if (!field || !_buffer) {
+        return false;
+    }
+    size_t tokenLength = std::strlen(token);
+    const char* p = _buffer->data() + field->value.offset;
+    const char* end = p + field->value.length;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) ++p;
+        const char* elementEnd = p;
+        while (elementEnd < end && *elementEnd != ',') ++elementEnd;
+        const char* trimmed = elementEnd;
+        while (trimmed > p && (trimmed[-1] == ' ' || trimmed[-1] == '\t')) --trimmed;
+        if (static_cast<size_t>(trimmed - p) == tokenLength && strncasecmp(p, token, tokenLength) == 0) {
+            return true;
+        }
+        p = elementEnd;
+    }
+    return false;
 }
-void Request::setBody(const std::string& body) { _body = body; }
 
-// Implement Request methods here
-// e.g., void Request::parse(const std::string& raw_request) { ... } 
\ No newline at end of file
+std::string Request::getHeader(HeaderId id) const {
+    const HeaderField* field = findHeader(id);
+    return field ? spanToString(field->value) : "";
+}
+
+std::string Request::getHeader(const std::string& key) const {
+    HeaderId id = KnownHeaders::lookup(key.data(), key.size());
+    if (id != HEADER_UNKNOWN) {
+        return getHeader(id);
+    }
+    // Uncommon header: linear scan over the names that didn't resolve to an id
+    if (_buffer) {
+        const char* data = _buffer->data();
+        for (size_t i = 0; i < _headers.size(); ++i) {
+            if (_headers[i].id == HEADER_UNKNOWN && _headers[i].name.length == key.size()
+                && strncasecmp(data + _headers[i].name.offset, key.data(), key.size()) == 0) {
+                return spanToString(_headers[i].value);
+            }
+        }
+    }
+    return ""; // Return empty string if header not found
+}
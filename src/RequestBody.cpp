@@ -0,0 +1,136 @@
+#include "RequestBody.hpp"
+#include <iostream>
+#include <cstdio>   // For perror
+#include <cstdlib>  // For mkstemp
+#include <cerrno>
+#include <vector>
+#include <fcntl.h>  // For open, O_TMPFILE
+#include <unistd.h> // For write, lseek, close, unlink
+
+std::string RequestBody::_tempDirectory = DEFAULT_BODY_TEMP_PATH;
+
+RequestBody::RequestBody() : _fd(-1), _size(0), _bufferSize(0) {}
+
+RequestBody::~RequestBody() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+RequestBody::RequestBody(RequestBody&& other) noexcept :
+    _memory(std::move(other._memory)),
+    _fd(other._fd),
+    _size(other._size),
+    _bufferSize(other._bufferSize)
+{
+    other._fd = -1;
+    other._size = 0;
+}
+
+RequestBody& RequestBody::operator=(RequestBody&& other) noexcept {
+    if (this != &other) {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+        _memory = std::move(other._memory);
+        _fd = other._fd;
+        _size = other._size;
+        _bufferSize = other._bufferSize;
+        other._fd = -1;
+        other._size = 0;
+    }
+    return *this;
+}
+
+void RequestBody::setTempDirectory(const std::string& path) {
+    _tempDirectory = path;
+}
+
+void RequestBody::setBufferSize(size_t bytes) {
+    _bufferSize = bytes;
+}
+
+bool RequestBody::consume(const char* data, size_t length) {
+    if (_fd < 0 && _memory.size() + length > _bufferSize) {
+        if (!spill()) {
+            return false;
+        }
+        std::cout << "RequestBody: over client_body_buffer_size (" << _bufferSize << " bytes), using temp file fd=" << _fd << std::endl;
+    }
+    if (_fd >= 0) {
+        if (!writeAll(data, length)) {
+            return false;
+        }
+    } else {
+        _memory.append(data, length);
+    }
+    _size += length;
+    return true;
+}
+
+void RequestBody::reset() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    std::string().swap(_memory); // Don't keep up to client_body_buffer_size per idle connection
+    _size = 0;
+}
+
+// Move the in-memory part into a fresh temp file; later data is appended to it
+bool RequestBody::spill() {
+    // O_TMPFILE: unnamed inode in the directory, freed on close, nothing left behind after a crash
+    _fd = open(_tempDirectory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (_fd < 0 && (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL)) {
+        // Filesystem without O_TMPFILE support: named file, unlinked straight away
+        std::string path = _tempDirectory + "/webserv_body_XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        _fd = mkstemp(name.data());
+        if (_fd >= 0) {
+            unlink(name.data());
+            fcntl(_fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    if (_fd < 0) {
+        perror(("RequestBody: cannot create temp file in " + _tempDirectory).c_str());
+        return false;
+    }
+    if (!writeAll(_memory.data(), _memory.size())) {
+        return false;
+    }
+    std::string().swap(_memory);
+    return true;
+}
+
+bool RequestBody::writeAll(const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(_fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("RequestBody: write to temp file failed");
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+int RequestBody::getFd() {
+    if (_fd < 0 && !spill()) {
+        return -1;
+    }
+    if (lseek(_fd, 0, SEEK_SET) < 0) {
+        perror("RequestBody: lseek failed");
+        return -1;
+    }
+    return _fd;
+}
+
+size_t RequestBody::getSize() const { return _size; }
+bool RequestBody::isInFile() const { return _fd >= 0; }
+const std::string& RequestBody::getMemory() const { return _memory; }
+size_t RequestBody::getBufferedBytes() const { return _memory.size(); }
@@ -1,10 +1,51 @@
 #include "Response.hpp"
+#include "HttpDate.hpp"
 #include <iostream> // Example include
-#include <sstream>
-#include <ctime> // For Date header
-#include <algorithm> // <-- Add this include for std::transform
+#include <strings.h> // For strcasecmp
+#include <utility> // For std::move
 
-Response::Response() : _version("HTTP/1.1"), _statusCode(200), _statusMessage("OK") {}
+// Complete status lines, so serializing one is a single append
+#define STATUS_LINE(code, reason) { code, reason, "HTTP/1.1 " #code " " reason "\r\n", \
+                                    sizeof("HTTP/1.1 " #code " " reason "\r\n") - 1 }
+static constexpr Response::StatusLine STATUS_LINES[] = {
+    STATUS_LINE(200, "OK"),
+    STATUS_LINE(201, "Created"),
+    STATUS_LINE(204, "No Content"),
+    STATUS_LINE(206, "Partial Content"),
+    STATUS_LINE(301, "Moved Permanently"),
+    STATUS_LINE(302, "Found"),
+    STATUS_LINE(304, "Not Modified"),
+    STATUS_LINE(400, "Bad Request"),
+    STATUS_LINE(401, "Unauthorized"),
+    STATUS_LINE(403, "Forbidden"),
+    STATUS_LINE(404, "Not Found"),
+    STATUS_LINE(405, "Method Not Allowed"),
+    STATUS_LINE(408, "Request Timeout"),
+    STATUS_LINE(412, "Precondition Failed"),
+    STATUS_LINE(413, "Payload Too Large"),
+    STATUS_LINE(414, "URI Too Long"),
+    STATUS_LINE(416, "Range Not Satisfiable"),
+    STATUS_LINE(431, "Request Header Fields Too Large"),
+    STATUS_LINE(500, "Internal Server Error"),
+    STATUS_LINE(501, "Not Implemented"),
+    STATUS_LINE(502, "Bad Gateway"),
+    STATUS_LINE(503, "Service Unavailable"),
+    STATUS_LINE(504, "Gateway Timeout"),
+    STATUS_LINE(505, "HTTP Version Not Supported"),
+};
+#undef STATUS_LINE
+
+const Response::StatusLine* Response::findStatusLine(int code) {
+    for (size_t i = 0; i < sizeof(STATUS_LINES) / sizeof(STATUS_LINES[0]); ++i) {
+        if (STATUS_LINES[i].code == code) {
+            return &STATUS_LINES[i];
+        }
+    }
+    return NULL;
+}
+
+Response::Response() : _version("HTTP/1.1"), _defaultVersion(true), _statusCode(200), _statusMessage("OK"),
+    _statusLine(findStatusLine(200)), _headerMask(0), _bodyPartsLength(0) {}
 
 Response::~Response() {
     // Destructor implementation
@@ -12,19 +53,58 @@ Response::~Response() {
 
 void Response::setVersion(const std::string& version) {
     _version = version;
+    _defaultVersion = (version == "HTTP/1.1");
 }
 
 void Response::setStatusCode(int code, const std::string& message) {
     _statusCode = code;
+    _statusLine = findStatusLine(code);
     if (message.empty()) {
         _statusMessage = getDefaultStatusMessage(code);
     } else {
         _statusMessage = message;
+        if (_statusLine && message != _statusLine->reason) {
+            _statusLine = NULL; // Custom reason phrase: formatted when serializing
+        }
     }
 }
 
+void Response::setHeader(HeaderId id, const std::string& value) {
+    if (id == HEADER_UNKNOWN) {
+        return;
+    }
+    if (_headerMask & (1ULL << id)) {
+        for (size_t i = 0; i < _headers.size(); ++i) {
+            if (_headers[i].id == id) {
+                _headers[i].value = value;
+                return;
+            }
+        }
+    }
+    HeaderEntry entry;
+    entry.id = id;
+    entry.value = value;
+    _headers.push_back(entry);
+    _headerMask |= 1ULL << id;
+}
+
 void Response::setHeader(const std::string& key, const std::string& value) {
-    _headers[key] = value;
+    HeaderId id = KnownHeaders::lookup(key.data(), key.size());
+    if (id != HEADER_UNKNOWN) {
+        setHeader(id, value);
+        return;
+    }
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        if (_headers[i].id == HEADER_UNKNOWN && strcasecmp(_headers[i].name.c_str(), key.c_str()) == 0) {
+            _headers[i].value = value;
+            return;
+        }
+    }
+    HeaderEntry entry;
+    entry.id = HEADER_UNKNOWN;
+    entry.name = key;
+    entry.value = value;
+    _headers.push_back(entry);
 }
 
 void Response::setBody(const std::string& body) {
@@ -34,6 +114,58 @@ void Response::setBody(const std::string& body) {
     // setHeader("Content-Length", std::to_string(body.length()));
 }
 
+void Response::setBody(std::string&& body) {
+    _body = std::move(body);
+}
+
+std::string Response::takeBody() {
+    std::string body;
+    body.swap(_body);
+    return body;
+}
+
+void Response::setBodyFile(const std::shared_ptr<OpenFile>& file, off_t offset, size_t length) {
+    _bodyParts.clear();
+    _bodyPartsLength = 0;
+    addBodyPart(file, offset, length);
+}
+
+void Response::addBodyPart(const std::string& text) {
+    BodyPart part;
+    part.text = text;
+    part.fileOffset = 0;
+    part.fileLength = 0;
+    _bodyParts.push_back(part);
+    _bodyPartsLength += text.length();
+}
+
+void Response::addBodyPart(const std::shared_ptr<OpenFile>& file, off_t offset, size_t length) {
+    BodyPart part;
+    part.file = file;
+    part.fileOffset = offset;
+    part.fileLength = length;
+    _bodyParts.push_back(part);
+    _bodyPartsLength += length;
+}
+
+void Response::setCached(const CachedResponse& cached) {
+    _cached = cached;
+}
+
+const std::vector<Response::BodyPart>& Response::getBodyParts() const { return _bodyParts; }
+const CachedResponse& Response::getCached() const { return _cached; }
+
+std::string Response::getHeader(HeaderId id) const {
+    if (_headerMask & (1ULL << id)) {
+        for (size_t i = 0; i < _headers.size(); ++i) {
+            if (_headers[i].id == id) {
+                return _headers[i].value;
+            }
+        }
+    }
+    return std::string();
+}
+
 int Response::getStatusCode() const {
     return _statusCode;
 }
@@ -45,87 +177,98 @@ const std::string& Response::getBody() const {
 
 // Generate the full HTTP response string
 std::string Response::toString() const {
-    std::ostringstream oss;
+    std::string out;
+    appendHead(out);
+    out += _body;
+    return out;
+}
 
-    // Status Line
-    oss << _version << " " << _statusCode << " " << _statusMessage << "\r\n";
-
-    // Headers
-    // Add mandatory headers if not present? (Date, Server)
-    bool dateSet = false;
-    bool serverSet = false;
-    bool connectionSet = false;
-    bool contentLengthSet = false;
-
-    for (std::map<std::string, std::string>::const_iterator it = _headers.begin(); it != _headers.end(); ++it) {
-        oss << it->first << ": " << it->second << "\r\n";
-        std::string lowerKey = it->first;
-        std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(), ::tolower);
-         if (lowerKey == "date") dateSet = true;
-         if (lowerKey == "server") serverSet = true;
-         if (lowerKey == "connection") connectionSet = true;
-         if (lowerKey == "content-length") contentLengthSet = true;
-    }
+std::string Response::toCacheableString() const {
+    std::string out;
+    appendHead(out, false);
+    out += _body;
+    return out;
+}
 
-     // Add Content-Length if body is present and header wasn't set manually
-     if (!contentLengthSet && !_body.empty()) {
-        oss << "Content-Length: " << _body.length() << "\r\n";
-     } else if (!contentLengthSet && _body.empty() && _statusCode != 204 && _statusCode != 304) {
-         // Add Content-Length: 0 for responses that normally have a body but it's empty
-         // Except for 204 No Content and 304 Not Modified
-         oss << "Content-Length: 0\r\n";
-     }
+// Append a non-negative number without going through a stream or a temporary string
+static void appendDecimal(std::string& out, unsigned long long value) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        out += digits[--count];
+    }
+}
 
+#define SERVER_HEADER "Server: webserv/0.1 (Custom)\r\n"
 
-    // Add Server header if not set
-    if (!serverSet) {
-        oss << "Server: webserv/0.1 (Custom)" << "\r\n"; // Example server name
+// Status line and headers, up to and including the blank line, appended to out.
+// Mandatory headers are detected from _headerMask bits, never by name.
+void Response::appendHead(std::string& out, bool withConnection) const {
+    size_t estimate = 128;
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        estimate += 32 + _headers[i].name.size() + _headers[i].value.size();
     }
+    out.reserve(out.size() + estimate);
 
-    // Add Date header if not set
-    if (!dateSet) {
-        char buf[100];
-        time_t now = time(0);
-        struct tm tm = *gmtime(&now);
-        strftime(buf, sizeof buf, "%a, %d %b %Y %H:%M:%S GMT", &tm);
-        oss << "Date: " << buf << "\r\n";
+    // Status Line
+    if (_statusLine && _defaultVersion) {
+        out.append(_statusLine->line, _statusLine->length);
+    } else {
+        out += _version;
+        out += ' ';
+        appendDecimal(out, static_cast<unsigned long long>(_statusCode));
+        out += ' ';
+        out += _statusMessage;
+        out.append("\r\n", 2);
     }
 
-     // Add Connection header if not set (default to close for HTTP/1.1 simplicity)
-    if (!connectionSet) {
-         oss << "Connection: close" << "\r\n";
+    for (size_t i = 0; i < _headers.size(); ++i) {
+        const HeaderEntry& entry = _headers[i];
+        if (entry.id == HEADER_CONNECTION && !withConnection) {
+            continue;
+        }
+        if (entry.id == HEADER_UNKNOWN) {
+            out += entry.name;
+        } else {
+            out += KnownHeaders::name(entry.id);
+        }
+        out.append(": ", 2);
+        out += entry.value;
+        out.append("\r\n", 2);
     }
 
+    if (!(_headerMask & (1ULL << HEADER_CONTENT_LENGTH))) {
+        // Content-Length: 0 too for responses that normally have a body,
+        // except 204 No Content and 304 Not Modified
+        if (!_body.empty() || !_bodyParts.empty() || (_statusCode != 204 && _statusCode != 304)) {
+            out.append("Content-Length: ", 16);
+            appendDecimal(out, _body.length() + _bodyPartsLength);
+            out.append("\r\n", 2);
+        }
+    }
+    if (!(_headerMask & (1ULL << HEADER_SERVER))) {
+        out.append(SERVER_HEADER, sizeof(SERVER_HEADER) - 1);
+    }
+    if (!(_headerMask & (1ULL << HEADER_DATE))) {
+        out.append("Date: ", 6);
+        out.append(HttpDate::current(), HTTP_DATE_LENGTH); // Refreshed once per second by the event loop
+        out.append("\r\n", 2);
+    }
+    if (!(_headerMask & (1ULL << HEADER_CONNECTION)) && withConnection) {
+        out.append("Connection: close\r\n", 19); // Default to close for HTTP/1.1 simplicity
+    }
 
     // End of headers
-    oss << "\r\n";
-
-    // Body (if present)
-    oss << _body;
-
-    return oss.str();
+    out.append("\r\n", 2);
 }
 
 // Helper to get default status messages
 std::string Response::getDefaultStatusMessage(int code) {
-    switch (code) {
-        case 200: return "OK";
-        case 201: return "Created";
-        case 204: return "No Content";
-        case 301: return "Moved Permanently";
-        case 302: return "Found"; // Or Temporary Redirect
-        case 400: return "Bad Request";
-        case 401: return "Unauthorized";
-        case 403: return "Forbidden";
-        case 404: return "Not Found";
-        case 405: return "Method Not Allowed";
-        case 413: return "Payload Too Large";
-        case 500: return "Internal Server Error";
-        case 501: return "Not Implemented";
-        case 503: return "Service Unavailable";
-        default: return "Unknown Status";
-    }
+    const StatusLine* status = findStatusLine(code);
+    return status ? status->reason : "Unknown Status";
 }
 
-// Implement Response methods here
-// e.g., std::string Response::toString() const { ... } 
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "ResponseCache.hpp"
+#include <cstring> // For memcpy
+
+ResponseCache::ResponseCache(size_t maxBytes) :
+    _maxBytes(maxBytes),
+    _bytes(0),
+    _hits(0),
+    _misses(0)
+{
+}
+
+bool ResponseCache::isEnabled() const { return _maxBytes > 0; }
+size_t ResponseCache::size() const { return _lru.size(); }
+size_t ResponseCache::getBytes() const { return _bytes; }
+unsigned long ResponseCache::getHits() const { return _hits; }
+unsigned long ResponseCache::getMisses() const { return _misses; }
+
+std::string ResponseCache::makeKey(size_t vhost, const std::string& path, const std::string& encoding) {
+    std::string key = std::to_string(vhost);
+    key += ' ';
+    key += encoding;
+    key += ' ';
+    key += path;
+    return key;
+}
+
+bool ResponseCache::locate(const std::string& serialized, size_t& headEnd, size_t& dateOffset) {
+    std::string::size_type blank = serialized.find("\r\n\r\n");
+    std::string::size_type date = serialized.find("\r\nDate: ");
+    if (blank == std::string::npos || date == std::string::npos || date > blank
+        || date + 8 + HTTP_DATE_LENGTH > blank + 2) {
+        return false;
+    }
+    headEnd = blank + 2;
+    dateOffset = date + 8;
+    return true;
+}
+
+void ResponseCache::refreshDate(std::shared_ptr<std::string>& blob, size_t dateOffset, time_t& dateSecond) {
+    time_t now = HttpDate::now();
+    if (dateSecond == now) {
+        return;
+    }
+    if (blob.use_count() > 1) {
+        // Still queued on some connection: leave those bytes alone
+        blob = std::make_shared<std::string>(*blob);
+    }
+    std::memcpy(&(*blob)[dateOffset], HttpDate::current(), HTTP_DATE_LENGTH);
+    dateSecond = now;
+}
+
+bool ResponseCache::find(const std::string& key, const std::shared_ptr<OpenFile>& file, CachedResponse& out) {
+    if (!isEnabled()) {
+        return false;
+    }
+    std::unordered_map<std::string, EntryList::iterator>::iterator it = _index.find(key);
+    if (it == _index.end()) {
+        ++_misses;
+        return false;
+    }
+    EntryList::iterator entry = it->second;
+    if (entry->source.lock() != file) {
+        // The path resolves to another file now (changed, or its open_file_cache entry expired)
+        erase(entry);
+        ++_misses;
+        return false;
+    }
+    refreshDate(entry->blob, entry->dateOffset, entry->dateSecond);
+    _lru.splice(_lru.begin(), _lru, entry); // Most recently used
+    ++_hits;
+    out.blob = entry->blob;
+    out.headEnd = entry->headEnd;
+    return true;
+}
+
+void ResponseCache::insert(const std::string& key, const std::shared_ptr<OpenFile>& file, const std::string& serialized) {
+    if (!isEnabled() || serialized.size() + key.size() > _maxBytes) {
+        return;
+    }
+    size_t headEnd;
+    size_t dateOffset;
+    if (!locate(serialized, headEnd, dateOffset)) {
+        return; // Not something we know how to patch
+    }
+    std::unordered_map<std::string, EntryList::iterator>::iterator existing = _index.find(key);
+    if (existing != _index.end()) {
+        erase(existing->second);
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.source = file;
+    entry.blob = std::make_shared<std::string>(serialized);
+    entry.headEnd = headEnd;
+    entry.dateOffset = dateOffset;
+    entry.dateSecond = HttpDate::now();
+    _lru.push_front(entry);
+    _index[key] = _lru.begin();
+    _bytes += serialized.size() + key.size();
+
+    while (_bytes > _maxBytes) {
+        erase(--_lru.end()); // Queued copies keep their blob alive
+    }
+}
+
+void ResponseCache::erase(EntryList::iterator entry) {
+    _bytes -= entry->blob->size() + entry->key.size();
+    _index.erase(entry->key);
+    _lru.erase(entry);
+}
@@ -4,6 +4,9 @@
 #include "Request.hpp"
 #include "Response.hpp"
 #include "Client.hpp" // Include Client header
+#include "Upgrade.hpp"
+#include "CharScan.hpp"
+#include "HttpDate.hpp"
 #include <iostream> // Example include
 #include <stdexcept> // For runtime_error
 #include <unistd.h>  // for close
@@ -13,24 +16,78 @@
 #include <netinet/in.h> // Include inet for accept/inet_ntoa
 #include <arpa/inet.h> // Include inet_ntoa
 #include <sys/stat.h> // For stat()
-#include <fstream>   // For ifstream
+#include <memory>    // For std::shared_ptr
 #include <sstream>   // For stringstream
-#include <utility> // For std::piecewise_construct, std::move
-#include <tuple>   // For std::forward_as_tuple
+#include <utility> // For std::move
 #include <cerrno> // For errno
 #include <cstdio> // For perror
-
-Server::Server(const Config& config) : _config(config), _epollFd(-1) {
+#include <strings.h> // For strncasecmp
+#include <cstdlib> // For strtod
+#include <zlib.h> // For gzip
+#include <ctime> // For clock_gettime
+#include <sys/wait.h> // For waitpid
+#include <sys/eventfd.h> // For eventfd
+#include <algorithm> // For std::min
+
+Server::Server(const Config& config) :
+    _config(config),
+    _listenEvents(EPOLLIN),
+    _activeClients(0),
+    _closingClients(0),
+    _completionIo(false),
+    _acceptWakeups(0),
+    _acceptedTotal(0),
+    _acceptBatchMax(0),
+    _bufferedBytes(0),
+    _acceptPaused(false),
+    _shedTotal(0),
+    _fileCache(config.getOpenFileCacheMax(), config.getOpenFileCacheValidMs()),
+    _responseCache(config.getResponseCacheSize()),
+    _gzipCache(config.getGzip() ? config.getGzipCacheSize() : 0),
+    _nowMs(monotonicMs()),
+    _draining(false),
+    _newBinary(-1),
+    _drainPending(false),
+    _wakeupFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    _wakeupHandler(EventHandler::WAKEUP)
+{
     std::memset(_events, 0, sizeof(_events)); // Clear events buffer
     std::cout << "Server object created." << std::endl;
     // Initialization logic moved to init()
 }
 
+Server::Server(const Config& config, const std::vector<int>& inheritedListeners) :
+    _config(config),
+    _inheritedListeners(inheritedListeners),
+    _listenEvents(EPOLLIN | EPOLLEXCLUSIVE),
+    _activeClients(0),
+    _closingClients(0),
+    _completionIo(false),
+    _acceptWakeups(0),
+    _acceptedTotal(0),
+    _acceptBatchMax(0),
+    _bufferedBytes(0),
+    _acceptPaused(false),
+    _shedTotal(0),
+    _fileCache(config.getOpenFileCacheMax(), config.getOpenFileCacheValidMs()),
+    _responseCache(config.getResponseCacheSize()),
+    _gzipCache(config.getGzip() ? config.getGzipCacheSize() : 0),
+    _nowMs(monotonicMs()),
+    _draining(false),
+    _newBinary(-1),
+    _drainPending(false),
+    _wakeupFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    _wakeupHandler(EventHandler::WAKEUP)
+{
+    std::memset(_events, 0, sizeof(_events));
+    std::cout << "Server object created with " << _inheritedListeners.size() << " inherited listener(s)." << std::endl;
+}
+
 Server::~Server() {
     std::cout << "Server object destroying..." << std::endl;
-    if (_epollFd >= 0) {
-        std::cout << "Closing epoll fd: " << _epollFd << std::endl;
-        close(_epollFd);
+    _poller.reset(); // Closes the epoll/io_uring fd
+    if (_wakeupFd >= 0) {
+        close(_wakeupFd);
     }
     // Sockets in _listeningSockets and _clientSockets will be closed
     // by their own destructors when the vectors/maps are cleared.
@@ -39,10 +96,20 @@ Server::~Server() {
 
 bool Server::init() {
     try {
-        // TODO: Replace with actual config parsing to get ports & hosts
-        // For default.conf: listen 127.0.0.1:8080;
+        // Listeners already bound by the master process: just adopt them
+        for (size_t i = 0; i < _inheritedListeners.size(); ++i) {
+            Socket listener(0);
+            if (!listener.adopt(_inheritedListeners[i])) {
+                std::cerr << "Failed to adopt inherited listener fd=" << _inheritedListeners[i] << std::endl;
+                return false;
+            }
+            _listeningSockets.emplace_back(std::move(listener));
+        }
+
         std::vector<std::pair<std::string, int> > listeners;
-        listeners.push_back(std::make_pair("127.0.0.1", 8080)); // Use host from config
+        if (_inheritedListeners.empty()) {
+            listeners = _config.getListeners();
+        }
 
         // --- Setup based on config ---
         for (size_t i = 0; i < listeners.size(); ++i) {
@@ -51,7 +118,12 @@ bool Server::init() {
 
             std::cout << "Setting up listener on " << host << ":" << port << std::endl;
             Socket listener(port);
-            if (!listener.init(host)) { // Pass host to init
+            // With several worker threads every Server binds its own SO_REUSEPORT listener
+            bool reusePort = _config.getWorkerThreads() > 1;
+            // After a binary upgrade the old process's listener is adopted instead of re-bound
+            int inheritedFd = Upgrade::claimListener(host, port);
+            bool ready = inheritedFd >= 0 ? listener.adopt(inheritedFd) : listener.init(host, reusePort);
+            if (!ready) {
                  std::cerr << "Failed to initialize listener socket on " << host << ":" << port << std::endl;
                  return false;
             }
@@ -59,14 +131,42 @@ bool Server::init() {
             _listeningSockets.emplace_back(std::move(listener));
         }
         // --- End Setup ---
+        Upgrade::closeUnclaimedListeners();
+
+        // Preallocate the client slab; pointers into it are handed to the poller, so it is never resized
+        size_t slabSize = static_cast<size_t>(_config.getWorkerConnections());
+        _clientSlab.resize(slabSize);
+        _freeClients.reserve(slabSize);
+        _releasedClients.reserve(slabSize);
+        for (size_t i = slabSize; i > 0; --i) {
+            _freeClients.push_back(&_clientSlab[i - 1]);
+        }
+        std::cout << "Client slab allocated with " << slabSize << " slots." << std::endl;
 
-        createEpoll();
+        createPoller();
 
-        // Add all listening sockets to epoll
+        // Add all listening sockets to the poller.
+        // Listeners shared with sibling worker processes use EPOLLEXCLUSIVE so a new
+        // connection wakes only one worker instead of the whole fleet.
+        // Listener i is getListeners()[i] in every mode (bind order, inherited fds, upgrades)
+        std::vector<std::pair<std::string, int> > listens = _config.getListeners();
+        _listenerHandlers.reserve(_listeningSockets.size());
         for (size_t i = 0; i < _listeningSockets.size(); ++i) {
-             addSocketToEpoll(_listeningSockets[i].getFd(), EPOLLIN); // Monitor for incoming connections
-             std::cout << "Added listening socket fd=" << _listeningSockets[i].getFd() << " to epoll." << std::endl;
+             size_t server = i < listens.size() ? _config.getServerIndex(listens[i]) : 0;
+             _listenerHandlers.push_back(ListenerHandler(_listeningSockets[i].getFd(), server));
+        }
+        for (size_t i = 0; i < _listeningSockets.size(); ++i) {
+             watchListener(i); // Monitor for incoming connections
+             std::cout << "Added listening socket fd=" << _listeningSockets[i].getFd() << " to " << _poller->name() << "." << std::endl;
+        }
+        if (_fileCache.getWatchFd() >= 0) {
+            addSocketToPoller(_fileCache.getWatchFd(), EPOLLIN | EPOLLET, &_fileCache); // inotify invalidation
         }
+        if (_wakeupFd >= 0) {
+            addSocketToPoller(_wakeupFd, EPOLLIN, &_wakeupHandler); // requestDrain() from another thread
+        }
+        std::cout << "open_file_cache: " << (_fileCache.isEnabled() ? "on" : "off") << std::endl;
+        _errorPages.load(_config);
 
     } catch (const std::exception& e) {
         std::cerr << "Server initialization failed: " << e.what() << std::endl;
@@ -75,275 +175,968 @@ bool Server::init() {
     return true;
 }
 
-void Server::createEpoll() {
-    _epollFd = epoll_create1(0); // Use epoll_create1 for flags if needed (like EPOLL_CLOEXEC)
-    if (_epollFd < 0) {
-        perror("epoll_create1 failed");
-        throw std::runtime_error("Failed to create epoll instance");
-    }
-    std::cout << "Epoll instance created (fd=" << _epollFd << ")." << std::endl;
+void Server::createPoller() {
+    _poller.reset(Poller::create(_config.getEventBackend()));
+    _completionIo = _poller->supportsCompletions();
+    std::cout << "Event backend: " << _poller->name() << std::endl;
+    std::cout << "Request scanning: " << CharScan::implementation() << std::endl;
 }
 
-void Server::addSocketToEpoll(int fd, uint32_t events) {
-    struct epoll_event event;
-    event.data.fd = fd;
-    event.events = events; // e.g., EPOLLIN | EPOLLOUT | EPOLLET (Edge Triggered)
-    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
-        perror("epoll_ctl(ADD) failed");
-        // Consider closing fd or throwing an exception
-        throw std::runtime_error("Failed to add socket to epoll");
-    }
+void Server::addSocketToPoller(int fd, uint32_t events, EventHandler* handler) {
+    _poller->add(fd, events, handler); // Throws on failure
 }
 
-void Server::removeSocketFromEpoll(int fd) {
-     if (_epollFd >= 0 && fd >= 0) {
-        if (epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, NULL) < 0) {
-            perror("epoll_ctl(DEL) failed");
-            // Log error, but might not need to throw, maybe the fd was already closed
-        }
+void Server::removeSocketFromPoller(int fd) {
+     if (_poller && fd >= 0) {
+        _poller->remove(fd);
      }
 }
 
+// With completion I/O a listener has a multishot accept instead of a registration
+void Server::watchListener(size_t index) {
+    int fd = _listeningSockets[index].getFd();
+    if (!_completionIo) {
+        addSocketToPoller(fd, _listenEvents, &_listenerHandlers[index]);
+    } else if (!_poller->acceptMultishot(fd, &_listenerHandlers[index])) {
+        throw std::runtime_error("Failed to queue accept on listener");
+    }
+}
+
+void Server::unwatchListener(size_t index) {
+    int fd = _listeningSockets[index].getFd();
+    if (_completionIo) {
+        _poller->cancel(fd); // Done before returning: the caller may close the listener next
+    } else {
+        removeSocketFromPoller(fd);
+    }
+}
+
 void Server::run() {
-    if (!init()) { // Initialize sockets and epoll before running
+    if (!init()) { // Initialize sockets and poller before running
         std::cerr << "Server failed to initialize. Aborting." << std::endl;
         return;
     }
 
-    std::cout << "Server running... Waiting for events on epoll fd " << _epollFd << std::endl;
+    std::cout << "Server running... Waiting for events (" << _poller->name() << ")" << std::endl;
+
+    Upgrade::retireParent(); // Started by a binary upgrade: the old process can drain now
 
-    while (true) { // Main event loop
-        int numEvents = epoll_wait(_epollFd, _events, MAX_EVENTS, -1); // Wait indefinitely (-1 timeout)
+    // Closed slots are waited for too: the kernel may still be writing to their buffers
+    while (!_draining || _activeClients > 0 || _closingClients > 0) { // Main event loop
+        handleSignals();
+        if (_draining && _activeClients == 0 && _closingClients == 0) {
+            break;
+        }
+        // Sleep until the next timer is due (-1 = no timers armed, wait indefinitely)
+        int timeoutMs = _timers.nextTimeoutMs(monotonicMs());
+        int numEvents = _poller->wait(_events, MAX_EVENTS, timeoutMs);
+        _nowMs = monotonicMs();
+        HttpDate::refresh(); // Date header for every response of this iteration
 
         if (numEvents < 0) {
-            perror("epoll_wait failed");
-            // Handle specific errors like EINTR if needed, otherwise maybe break/throw
+            // Check errno before perror(), which may overwrite it
             if (errno == EINTR) {
-                continue; // Interrupted by signal, just restart wait
+                continue; // Interrupted by signal: handleSignals() picks up the flag
             }
+            perror("Poller wait failed");
             // Potentially critical error
-             throw std::runtime_error("epoll_wait error");
+             throw std::runtime_error("Poller wait error");
         }
 
-        // std::cout << "epoll_wait returned " << numEvents << " event(s)." << std::endl;
-        handleEpollEvents(numEvents);
+        // std::cout << "Poller returned " << numEvents << " event(s)." << std::endl;
+        handlePollerEvents(numEvents);
+        expireTimers();
+        updateAcceptState();
+    }
+    std::cout << "Server drained, exiting event loop." << std::endl;
+    logBufferPool();
+}
 
-        // TODO: Add graceful shutdown logic (e.g., on SIGINT/SIGTERM)
+volatile sig_atomic_t Server::_drainRequested = 0;
+volatile sig_atomic_t Server::_upgradeRequested = 0;
+volatile sig_atomic_t Server::_childExited = 0;
+
+void Server::signalHandler(int signum) {
+    if (signum == SIGQUIT) {
+        _drainRequested = 1;
+    } else if (signum == SIGUSR2) {
+        _upgradeRequested = 1;
+    } else if (signum == SIGCHLD) {
+        _childExited = 1;
     }
 }
 
-void Server::handleEpollEvents(int numEvents) {
-    for (int i = 0; i < numEvents; ++i) {
-        int fd = _events[i].data.fd;
-        uint32_t revents = _events[i].events;
+void Server::installSignalHandlers(bool handleUpgrade) {
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = Server::signalHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0; // No SA_RESTART: Poller::wait must return EINTR so the loop sees the flag
+    sigaction(SIGQUIT, &sa, NULL);
+    if (handleUpgrade) {
+        sigaction(SIGUSR2, &sa, NULL);
+        sigaction(SIGCHLD, &sa, NULL); // Reap a new binary that fails to take over
+    } else {
+        signal(SIGUSR2, SIG_IGN); // The master performs upgrades, not its workers
+    }
+}
 
-        // Check if the event is on a listening socket
-        bool isListener = false;
-        for (size_t j = 0; j < _listeningSockets.size(); ++j) {
-            if (fd == _listeningSockets[j].getFd()) {
-                isListener = true;
-                break;
+void Server::handleSignals() {
+    if (_childExited) {
+        _childExited = 0;
+        int status = 0;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            if (pid == _newBinary) {
+                // Upgrade failed (bad binary or config): keep serving with this one
+                std::cerr << "New binary (pid=" << pid << ") exited before taking over; upgrade aborted." << std::endl;
+                _newBinary = -1;
+            }
+        }
+    }
+    if (_upgradeRequested) {
+        _upgradeRequested = 0;
+        if (_draining) {
+            std::cerr << "Binary upgrade ignored: listeners already handed over." << std::endl;
+        } else if (_newBinary > 0) {
+            std::cerr << "Binary upgrade already in progress (pid=" << _newBinary << ")." << std::endl;
+        } else {
+            std::vector<int> listenerFds;
+            for (size_t i = 0; i < _listeningSockets.size(); ++i) {
+                listenerFds.push_back(_listeningSockets[i].getFd());
             }
+            _newBinary = Upgrade::spawnNewBinary(listenerFds); // The new binary sends us SIGQUIT once it's serving
         }
+    }
+    if ((_drainRequested || _drainPending) && !_draining) {
+        beginDrain();
+    }
+}
+
+void Server::requestDrain() {
+    _drainPending = true;
+    uint64_t one = 1;
+    if (_wakeupFd >= 0 && write(_wakeupFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write failed");
+    }
+}
+
+// Graceful shutdown: the listeners (shared with the new binary or sibling workers)
+// are closed here so this process accepts nothing new; connections with a
+// request in flight get their response with "Connection: close", idle ones go now.
+void Server::beginDrain() {
+    _draining = true;
+    std::cout << "Draining: closing " << _listeningSockets.size() << " listener(s), "
+              << _activeClients << " connection(s) still open." << std::endl;
+    for (size_t i = 0; i < _listeningSockets.size() && !_acceptPaused; ++i) {
+        unwatchListener(i);
+    }
+    _listeningSockets.clear(); // Socket destructors close the fds
 
-        // Find the client associated with the fd
-        std::map<int, Client>::iterator clientIt = _clients.find(fd);
+    for (size_t i = 0; i < _clientSlab.size(); ++i) {
+        Client& client = _clientSlab[i];
+        if (client.getFd() >= 0 && isIdle(client)) {
+            handleClientDisconnection(client);
+        }
+    }
+    recycleReleasedClients();
+}
 
-        if (isListener) {
+bool Server::isIdle(const Client& client) const {
+    return client.getState() == AWAITING_REQUEST
+           && client.getRawRequest().empty()
+           && !client.hasPendingOutput();
+}
+
+void Server::handlePollerEvents(int numEvents) {
+    for (int i = 0; i < numEvents; ++i) {
+        EventHandler* handler = _events[i].handler;
+        uint32_t revents = _events[i].events;
+        if (_events[i].op != POLLER_READY) {
+            handleCompletion(_events[i]);
+            continue;
+        }
+
+        if (handler->handlerType == EventHandler::LISTENER) {
             // Event on a listening socket: incoming connection
              if (revents & EPOLLIN) {
-                // std::cout << "Handling new connection on listener fd=" << fd << std::endl;
-                handleNewConnection(fd);
+                handleNewConnection(*static_cast<ListenerHandler*>(handler));
             }
              // TODO: Handle listener errors? (EPOLLERR/HUP unlikely but possible)
-        } else if (clientIt != _clients.end()) {
+        } else if (handler->handlerType == EventHandler::CLIENT) {
             // Event on an existing client connection
-            Client& client = clientIt->second;
+            Client& client = *static_cast<Client*>(handler);
+            if (client.getFd() < 0) {
+                // Slot was released earlier in this batch (stale event for a closed fd)
+                continue;
+            }
 
             if (revents & (EPOLLERR | EPOLLHUP)) {
                 // Error or hang-up on client socket
-                handleClientError(fd);
+                handleClientError(client);
             } else {
                 if (revents & EPOLLIN) {
                     // Data available to read from client
-                    // std::cout << "EPOLLIN event on client fd=" << fd << std::endl;
-                    handleClientRead(fd);
+                    handleClientRead(client);
                 }
                  // Check EPOLLOUT *after* EPOLLIN, as read might trigger a response write
-                if (revents & EPOLLOUT) {
+                if ((revents & EPOLLOUT) && client.getFd() >= 0) {
                     // Socket is ready for writing
-                    // std::cout << "EPOLLOUT event on client fd=" << fd << std::endl;
-                    handleClientWrite(fd);
+                    handleClientWrite(client);
                 }
             }
 
-             // Check if client is finished after handling events
-             // Close non-keep-alive connections after response sent.
-             if (client.getState() == RESPONSE_SENT) {
-                  // TODO: Implement Keep-Alive check based on request/response headers
-                 bool keepAlive = false; // Default to close for simplicity
-                 if (keepAlive) {
-                     // client.clear(); // Reset client state
-                     // modifySocketInEpoll(fd, EPOLLIN | EPOLLET); // Wait for next request
-                     // std::cout << "Client fd=" << fd << ": Keep-Alive - ready for next request." << std::endl;
-                 } else {
-                     std::cout << "Client fd=" << fd << ": Response sent, closing connection." << std::endl;
-                     handleClientDisconnection(fd);
-                 }
-             }
+             finishClientEvent(client);
 
+        } else if (handler->handlerType == EventHandler::FILE_CACHE) {
+            static_cast<OpenFileCache*>(handler)->processEvents();
+        } else if (handler->handlerType == EventHandler::WAKEUP) {
+            uint64_t count;
+            if (read(_wakeupFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                perror("eventfd read failed");
+            } // handleSignals() at the top of the loop acts on _drainPending
         } else {
-            // Event on an fd that is neither listener nor known client
-            // Might happen if client disconnected abruptly before DEL_CTL processed
-             std::cerr << "Event on unknown fd=" << fd << ". Removing from epoll." << std::endl;
-            removeSocketFromEpoll(fd); // Clean up epoll registration
+            // CGI pipes are not wired into the loop yet
+             std::cerr << "Event for unsupported handler type " << handler->handlerType << "." << std::endl;
         }
     }
+    // Only now can freed slots be reused: later events in this batch may still point at them
+    recycleReleasedClients();
 }
 
-void Server::handleNewConnection(int listenerFd) {
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    int clientFd = accept(listenerFd, (struct sockaddr*)&client_addr, &client_len);
+// Check if client is finished after handling its events.
+// Keep-alive connections go back to AWAITING_REQUEST on their own once the
+// output queue drains; RESPONSE_SENT means the last response said "close".
+void Server::finishClientEvent(Client& client) {
+    if (client.getFd() < 0) {
+        return;
+    }
+    if (client.getState() == RESPONSE_SENT || (_draining && isIdle(client))) {
+        std::cout << "Client fd=" << client.getFd() << ": Response sent, closing connection." << std::endl;
+        handleClientDisconnection(client);
+        return;
+    }
+    if (isIdle(client)) {
+        client.returnBuffers(_bufferPool); // Idle keep-alive connections hold no buffer
+    }
+    refreshClientTimer(client); // Still active: re-arm for the phase it's in now
+    accountMemory(client);
+}
 
-    if (clientFd < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            perror("accept failed");
+// Completion-based I/O: the poller reports what an accept, recv, send or file read
+// it performed returned. Multishot operations (accept, recv) report several times;
+// the slot's count of owed completions drops when one reports its last.
+void Server::handleCompletion(const PollerEvent& event) {
+    if (event.handler->handlerType == EventHandler::LISTENER) {
+        handleAcceptCompletion(*static_cast<ListenerHandler*>(event.handler), event);
+        return;
+    }
+    Client& client = *static_cast<Client*>(event.handler);
+    if (!event.more) {
+        client.finishPendingOperation();
+    }
+    if (client.getFd() < 0) {
+        // Closed already (the operation was cancelled, or finished first): free the slot with the last one
+        if (client.getPendingOperations() == 0) {
+            --_closingClients;
+            releaseClientSlot(client);
         }
         return;
     }
+    if (event.op == POLLER_RECV) {
+        handleClientReceived(client, event);
+    } else {
+        handleClientSent(client, event);
+    }
+    finishClientEvent(client);
+}
+
+void Server::handleAcceptCompletion(const ListenerHandler& listener, const PollerEvent& event) {
+    if (!event.more && event.result != -ECANCELED && !_draining && !_acceptPaused) {
+        watchListener(static_cast<size_t>(&listener - &_listenerHandlers[0])); // Stopped on an error: re-arm
+    }
+    if (event.result < 0) {
+        if (event.result != -ECANCELED && event.result != -ECONNABORTED && event.result != -EINTR) {
+            std::cerr << "accept failed: " << strerror(-event.result) << std::endl;
+        }
+        return;
+    }
+    int clientFd = event.result;
+    if (_draining) {
+        close(clientFd); // Accepted just before the cancel: the listener is already handed over
+        return;
+    }
+    // Taken off the backlog already, so an overloaded server can only turn it away
+    if (isOverloaded()) {
+        shedConnection(clientFd);
+        return;
+    }
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr)); // Multishot accept doesn't report the peer
+    if (admitConnection(clientFd, addr, listener.server)) {
+        std::cout << "Accepted new connection (fd=" << clientFd << ")." << std::endl;
+    }
+    if (isOverloaded() && !_config.getOverload503()) {
+        pauseAccept(); // Now rather than after the batch: later connections wait in the backlog
+    }
+}
+
+void Server::handleClientReceived(Client& client, const PollerEvent& event) {
+    bool peerClosed = false;
+    if (event.result > 0) {
+        client.appendReceived(_bufferPool, event.data, static_cast<size_t>(event.result));
+        if (client.hasCompleteHeaders()) {
+            client.isRequestReady(); // Body bytes go to the request body as they arrive
+        }
+    } else if (event.result == 0) {
+        std::cout << "Client fd=" << client.getFd() << ": Connection closed by peer." << std::endl;
+        peerClosed = true; // Still answer requests that arrived before the FIN
+    } else if (event.result != -ENOBUFS) {
+        std::cerr << "Client fd=" << client.getFd() << ": recv failed (" << strerror(-event.result) << ")." << std::endl;
+        handleClientDisconnection(client, true);
+        return;
+    }
+    // Out of provided buffers (-ENOBUFS), or stopped for another reason: the data waits in the socket
+    if (!event.more && !peerClosed && !startReceiving(client)) {
+        handleClientDisconnection(client, true);
+        return;
+    }
+
+    serveBufferedRequests(client);
+    handleClientWrite(client);
+    if (client.getFd() >= 0 && peerClosed) {
+        client.setKeepAlive(false); // Nothing more will arrive; close once the queue drains
+        if (!client.hasPendingOutput()) {
+            handleClientDisconnection(client);
+        } else {
+            client.setState(SENDING_RESPONSE);
+        }
+    }
+}
+
+void Server::handleClientSent(Client& client, const PollerEvent& event) {
+    client.setSending(false);
+    ssize_t result = event.op == POLLER_READ ? client.completeFileRead(event.result)
+                                             : client.completeSend(event.result);
+    if (result < 0) {
+        handleClientDisconnection(client, true);
+        return;
+    }
+    handleClientWrite(client); // Serve pipelined requests held back by the cap, send what's next
+}
 
-    // Make the accepted socket non-blocking
-    if (fcntl(clientFd, F_SETFL, O_NONBLOCK) < 0) {
-        perror("fcntl(O_NONBLOCK) for client failed");
+bool Server::startReceiving(Client& client) {
+    if (!_poller->recvMultishot(client.getFd(), &client)) {
+        return false;
+    }
+    client.addPendingOperation();
+    return true;
+}
+
+void Server::submitClientSend(Client& client) {
+    if (client.isSending() || !client.hasPendingOutput()) {
+        return;
+    }
+    int flags = 0;
+    bool queued;
+    const struct msghdr* msg = client.prepareSend(flags);
+    if (msg) {
+        queued = _poller->sendMsg(client.getFd(), msg, flags, &client);
+    } else {
+        int fileFd;
+        size_t length;
+        off_t offset;
+        char* chunk = client.prepareFileRead(fileFd, length, offset);
+        queued = _poller->read(fileFd, chunk, length, offset, &client);
+    }
+    if (!queued) {
+        handleClientDisconnection(client, true);
+        return;
+    }
+    client.setSending(true);
+    client.addPendingOperation();
+}
+
+// Drain the listener: accept until EAGAIN (or the accept_batch cap) so a burst of
+// connections is admitted in one wake-up instead of one per Poller::wait round.
+// accept4() returns the socket already non-blocking/close-on-exec (one syscall per client).
+void Server::handleNewConnection(const ListenerHandler& listener) {
+    const int listenerFd = listener.fd;
+    const unsigned long maxBatch = static_cast<unsigned long>(_config.getAcceptBatch());
+    unsigned long accepted = 0;
+
+    while (accepted < maxBatch) {
+        // At capacity: either stop accepting until load drops (the kernel backlog holds
+        // the rest), or keep draining the backlog and turn everyone away with a cheap 503.
+        bool overloaded = isOverloaded();
+        if (overloaded && !_config.getOverload503()) {
+            pauseAccept();
+            break;
+        }
+
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int clientFd = accept4(listenerFd, (struct sockaddr*)&client_addr, &client_len,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (clientFd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue; // Try the next pending connection
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept4 failed");
+            }
+            break; // Backlog drained (or hard error, e.g. EMFILE)
+        }
+        ++accepted;
+
+        if (overloaded) {
+            shedConnection(clientFd);
+            continue;
+        }
+        if (admitConnection(clientFd, client_addr, listener.server)) {
+            std::cout << "Accepted new connection (fd=" << clientFd << ") from "
+                      << inet_ntoa(client_addr.sin_addr) << ":" << ntohs(client_addr.sin_port) << std::endl;
+        }
+    }
+
+    ++_acceptWakeups;
+    _acceptedTotal += accepted;
+    if (accepted > _acceptBatchMax) {
+        _acceptBatchMax = accepted;
+    }
+    if (accepted > 1) {
+        std::cout << "Accepted " << accepted << " connections in one wake-up (listener fd=" << listenerFd
+                  << ", avg " << static_cast<double>(_acceptedTotal) / _acceptWakeups
+                  << "/wake-up, max " << _acceptBatchMax << ")." << std::endl;
+    }
+}
+
+// Give an accepted socket a slot and start reading from it; false if it was closed instead
+bool Server::admitConnection(int clientFd, const struct sockaddr_in& addr, size_t serverIndex) {
+    Client* client = allocateClient(clientFd, addr, serverIndex);
+    if (!client) {
+        std::cerr << "Client slab full (" << _clientSlab.size() << " connections), rejecting fd=" << clientFd << std::endl;
         close(clientFd);
+        return false;
+    }
+
+    if (_completionIo) {
+        if (!startReceiving(*client)) {
+            handleClientDisconnection(*client, true);
+            return false;
+        }
+    } else {
+        // Add the new client socket to the poller, monitoring for read events initially
+        // Use Edge Triggered (EPOLLET) for potentially better performance
+        try {
+            addSocketToPoller(clientFd, EPOLLIN | EPOLLET, client);
+        } catch (const std::exception&) {
+            handleClientDisconnection(*client, true);
+            return false;
+        }
+    }
+    refreshClientTimer(*client); // Starts client_header_timeout
+    return true;
+}
+
+// Take a slot from the free list and construct the connection in place
+Client* Server::allocateClient(int clientFd, const struct sockaddr_in& addr, size_t serverIndex) {
+    if (_freeClients.empty()) {
+        return NULL;
+    }
+    Client* client = _freeClients.back();
+    _freeClients.pop_back();
+    *client = Client(clientFd, addr);
+    client->getTimer().owner = client;
+    client->setServerIndex(serverIndex);
+    const std::vector<ServerConfig>& servers = _config.getServers();
+    if (serverIndex < servers.size()) {
+        client->setBodyLimits(servers[serverIndex].clientMaxBodySize, servers[serverIndex].clientBodyBufferSize);
+    }
+    ++_activeClients;
+    return client;
+}
+
+void Server::recycleReleasedClients() {
+    _freeClients.insert(_freeClients.end(), _releasedClients.begin(), _releasedClients.end());
+    _releasedClients.clear();
+}
+
+// Prebuilt once: shedding a connection costs one send() and no allocation
+static const char OVERLOAD_RESPONSE[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 20\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Service Unavailable\n";
+
+bool Server::isOverloaded() const {
+    size_t memoryLimit = _config.getWorkerMemoryLimit();
+    return _activeClients >= _clientSlab.size()
+           || (memoryLimit > 0 && _bufferedBytes >= memoryLimit);
+}
+
+void Server::pauseAccept() {
+    if (_acceptPaused || _draining) {
         return;
     }
+    for (size_t i = 0; i < _listeningSockets.size(); ++i) {
+        unwatchListener(i);
+    }
+    _acceptPaused = true;
+    std::cerr << "Overloaded (" << _activeClients << "/" << _clientSlab.size() << " connections, "
+              << _bufferedBytes << " bytes buffered): pausing accept." << std::endl;
+    logBufferPool();
+}
 
-    std::cout << "Accepted new connection (fd=" << clientFd << ") from "
-              << inet_ntoa(client_addr.sin_addr) << ":" << ntohs(client_addr.sin_port) << std::endl;
+// Resume below a low-water mark (90% of each limit) so accept isn't toggled per connection.
+// Completion I/O accepts without asking first, so it pauses here as soon as the limit is hit.
+void Server::updateAcceptState() {
+    if (_completionIo && !_acceptPaused && isOverloaded() && !_config.getOverload503()) {
+        pauseAccept();
+    }
+    if (!_acceptPaused || _draining) {
+        return;
+    }
+    size_t slack = _clientSlab.size() / 10 > 0 ? _clientSlab.size() / 10 : 1;
+    size_t memoryLimit = _config.getWorkerMemoryLimit();
+    if (_activeClients + slack > _clientSlab.size()
+        || (memoryLimit > 0 && _bufferedBytes > memoryLimit - memoryLimit / 10)) {
+        return;
+    }
+    for (size_t i = 0; i < _listeningSockets.size(); ++i) {
+        watchListener(i);
+    }
+    _acceptPaused = false;
+    std::cout << "Load dropped (" << _activeClients << " connections, " << _bufferedBytes
+              << " bytes buffered): resuming accept." << std::endl;
+}
 
-    // Add the new client socket to epoll, monitoring for read events initially
-    // Use Edge Triggered (EPOLLET) for potentially better performance
-    addSocketToEpoll(clientFd, EPOLLIN | EPOLLET);
+void Server::shedConnection(int clientFd) {
+    // Best effort: a full socket buffer or a reset just means the client sees the close
+    if (send(clientFd, OVERLOAD_RESPONSE, sizeof(OVERLOAD_RESPONSE) - 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+        // Nothing to do, the connection is being dropped anyway
+    }
+    close(clientFd);
+    if (++_shedTotal % 1000 == 1) {
+        std::cerr << "Overloaded: shed " << _shedTotal << " connection(s) with 503 so far." << std::endl;
+    }
+}
 
-    // Use emplace with piecewise construction
-    _clients.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(clientFd), // Arguments for key (int)
-        std::forward_as_tuple(clientFd, client_addr) // Arguments for value (Client)
-    );
+void Server::accountMemory(Client& client) {
+    size_t bytes = client.getBufferedBytes();
+    _bufferedBytes += bytes;
+    _bufferedBytes -= client.getAccountedBytes();
+    client.setAccountedBytes(bytes);
 }
 
-void Server::handleClientRead(int clientFd) {
-     std::map<int, Client>::iterator it = _clients.find(clientFd);
-    if (it == _clients.end()) return; // Should not happen if called correctly
-    Client& client = it->second;
+void Server::logBufferPool() const {
+    std::cout << "I/O buffers: " << _bufferPool.getInUse() << " in use, " << _bufferPool.getFree()
+              << " free, peak " << _bufferPool.getPeakInUse() << ", " << _bufferPool.getAllocations()
+              << " allocated (" << IO_BUFFER_SIZE << " bytes each)." << std::endl;
+}
 
+void Server::handleClientRead(Client& client) {
     // Loop reading data because we use Edge Triggering (EPOLLET)
+    bool peerClosed = false;
     while (true) {
-        ssize_t readResult = client.receiveData(); // Client reads data
+        ssize_t readResult = client.receiveData(_bufferPool); // Client reads data
 
         if (readResult == -1) { // Error reported by receiveData
-            handleClientDisconnection(clientFd, true);
+            handleClientDisconnection(client, true);
             return; // Stop processing this client
         } else if (readResult == 0) { // EOF reported by receiveData
-            handleClientDisconnection(clientFd);
-            return; // Stop processing this client
+            peerClosed = true; // Still answer requests that arrived before the FIN
+            break;
         } else if (readResult == -2) { // EAGAIN / EWOULDBLOCK reported by receiveData
             // No more data to read right now. Stop the reading loop for this event.
             break;
-        } else { // readResult > 0: Data was read
-            // Check if the request is complete *after* reading data.
-            // Client::receiveData internally sets state to REQUEST_RECEIVED if ready.
-            if (client.getState() == REQUEST_RECEIVED) {
-                  processRequest(client); // Process the complete request
-                  // Note: We might have read part of the *next* request in EPOLLET mode.
-                  // processRequest should handle this (e.g., by leaving remaining data
-                  // in the buffer for the next EPOLLIN). The current Request::parse
-                  // likely consumes only up to the body end.
-                  break; // Stop reading loop after processing a request
-            }
-            // If readResult > 0 but request not yet complete, continue loop
-            // (EPOLLET means we must read until EAGAIN/EWOULDBLOCK).
-            // The check `readResult < READ_BUFFER_SIZE` is removed,
-            // as we rely solely on the return value of receiveData()
-            // to know when to stop reading for this EPOLLIN event.
+        }
+        // readResult > 0: keep reading, EPOLLET means we must read until EAGAIN/EWOULDBLOCK
+        if (client.hasCompleteHeaders()) {
+            // Hand body bytes to the request body as they arrive, so a large upload
+            // never piles up in the connection buffer
+            client.isRequestReady();
         }
     }
-}
 
-void Server::handleClientWrite(int clientFd) {
-    std::map<int, Client>::iterator it = _clients.find(clientFd);
-    if (it == _clients.end() || it->second.getState() != SENDING_RESPONSE) {
-         // Not found or not in a state to send (e.g., already sent, or still reading)
-         // If not in SENDING_RESPONSE, maybe remove EPOLLOUT interest?
-         // std::cout << "Client fd=" << clientFd << " got EPOLLOUT but not in SENDING_RESPONSE state (" << (it == _clients.end() ? -1 : it->second.getState()) << "). Modifying epoll." << std::endl;
-         // modifySocketInEpoll(clientFd, EPOLLIN | EPOLLET); // Revert to only monitoring read
+    // The buffer may now hold several pipelined requests: answer all of them,
+    // then push the queued responses out together.
+    serveBufferedRequests(client);
+    handleClientWrite(client);
+    if (client.getFd() < 0) {
         return;
     }
-    Client& client = it->second;
 
-    ssize_t sendResult = client.sendData();
+    if (peerClosed) {
+        client.setKeepAlive(false); // Nothing more will arrive; close once the queue drains
+        if (!client.hasPendingOutput()) {
+            handleClientDisconnection(client);
+        } else {
+            client.setState(SENDING_RESPONSE);
+        }
+    }
+}
 
-    if (sendResult == -1) { // Error
-        handleClientDisconnection(clientFd, true);
-    } else if (sendResult == -2) { // EAGAIN / EWOULDBLOCK
-        // Kernel buffer is full, need to wait for EPOLLOUT again.
-        // Ensure EPOLLOUT is still set (it should be).
-        // std::cout << "Client fd=" << clientFd << ": send() would block, waiting for next EPOLLOUT." << std::endl;
-    } else if (client.isResponseFullySent()) {
-         // If response is fully sent, we might:
-         // 1. Close the connection (if not keep-alive) -> handled in handleEpollEvents
-         // 2. Switch back to read-only monitoring (if keep-alive)
-         // std::cout << "Client fd=" << clientFd << ": Finished sending. Modifying epoll to read-only." << std::endl;
-         // modifySocketInEpoll(clientFd, EPOLLIN | EPOLLET); // Switch back to only reading
+// Generate responses for every complete request in the buffer, in order.
+// Stops at a request that closes the connection and when MAX_PIPELINED_RESPONSES
+// are waiting, so a client that never reads can't make us buffer without bound.
+size_t Server::serveBufferedRequests(Client& client) {
+    size_t served = 0;
+    while (client.getFd() >= 0
+           && client.isKeepAlive()
+           && client.getQueuedResponses() < MAX_PIPELINED_RESPONSES
+           && client.isRequestReady()) {
+        processRequest(client);
+        client.clear(); // Drop the consumed request, keep the pipelined bytes after it
+        ++served;
+    }
+    if (served > 1) {
+        std::cout << "Client fd=" << client.getFd() << ": " << served << " pipelined requests served in one pass." << std::endl;
+    }
+    return served;
+}
 
-         // The check and potential disconnection/state reset is done in handleEpollEvents
-         // after all events for this iteration are processed.
+void Server::handleClientWrite(Client& client) {
+    if (_completionIo) {
+        // The poller sends: room freed in the queue only shows once a send completes
+        serveBufferedRequests(client);
+        submitClientSend(client);
+        return;
+    }
+    // Flush what is queued; if that freed room in the queue, serve the pipelined
+    // requests that were held back and flush again.
+    while (client.getFd() >= 0) {
+        if (client.hasPendingOutput()) {
+            ssize_t sendResult = client.sendData();
+            if (sendResult == -1) { // Error
+                handleClientDisconnection(client, true);
+                return;
+            }
+            if (client.hasPendingOutput()) {
+                break; // Kernel buffer is full: wait for EPOLLOUT
+            }
+        }
+        if (serveBufferedRequests(client) == 0) {
+            break;
+        }
+    }
+    if (client.getFd() >= 0) {
+        updateWriteInterest(client);
     }
-    // If sendResult > 0 but not fully sent, do nothing; epoll will trigger EPOLLOUT again if needed.
 }
 
-void Server::handleClientError(int clientFd) {
-    std::cerr << "EPOLLERR/EPOLLHUP detected on client fd=" << clientFd << std::endl;
-    handleClientDisconnection(clientFd, true); // Treat as an error disconnection
+void Server::handleClientError(Client& client) {
+    std::cerr << "EPOLLERR/EPOLLHUP detected on client fd=" << client.getFd() << std::endl;
+    handleClientDisconnection(client, true); // Treat as an error disconnection
 }
 
 void Server::processRequest(Client& client) {
     client.setState(GENERATING_RESPONSE);
+    client.incrementRequestCount();
     // std::cout << "Processing request for fd=" << client.getFd() << std::endl;
 
-    // 1. Get the parsed request. getRequest() handles calling Request::parse()
+    // 1. Get the parsed request (the parser already ran as bytes arrived)
     Request& request = client.getRequest();
 
     Response response;
     // Use the getter method here
-    if (!client.isParsed()) {
-        std::cerr << "processRequest called but request not marked as parsed for fd=" << client.getFd() << std::endl;
-        response = generateErrorResponse(400, _config); // Bad Request
+    if (!client.isParsed() || !client.isRequestValid()) {
+        int errorCode = request.getErrorCode() ? request.getErrorCode() : 400;
+        std::cerr << "processRequest: request rejected by the parser for fd=" << client.getFd() << std::endl;
+        response = generateErrorResponse(errorCode, _config, client.getServerIndex()); // 400, 413, 414, 431, 500, 501 or 505
     } else {
-        // 2. Generate Response based on parsed request and config
-        // TODO: Pass the actual relevant ServerConfig block
-        response = generateResponse(request, _config);
+        // The body (if any) is in client.getRequestBody(): in memory, or in a temp
+        // file once it outgrew client_body_buffer_size. Handlers read it via getFd().
+        RequestBody& body = client.getRequestBody();
+        if (body.getSize() > 0) {
+            std::cout << "Request body: " << body.getSize() << " bytes "
+                      << (body.isInFile() ? "in a temp file" : "in memory") << std::endl;
+        }
+        // 2. Generate Response from the server block of the listener the connection came in on
+        response = generateResponse(request, _config, client.getServerIndex());
     }
 
 
-    // 3. Set the response in the client object (this now calls response.toString())
-    client.setResponse(response);
+    // 3. Persistent connection? Never after a malformed request (its end is unknown),
+    //    once the connection has served keepalive_requests requests, or while draining.
+    bool keepAlive = !_draining
+                     && client.isRequestValid()
+                     && request.wantsKeepAlive()
+                     && client.getRequestCount() < _config.getKeepaliveRequests();
+    client.setKeepAlive(keepAlive);
+    response.setHeader(HEADER_CONNECTION, keepAlive ? "keep-alive" : "close");
 
-    // 4. Modify epoll interest to include EPOLLOUT
-    modifySocketInEpoll(client.getFd(), EPOLLIN | EPOLLOUT | EPOLLET);
+    // 4. Queue the response behind earlier pipelined ones (head and body as separate segments).
+    //    The caller flushes the queue once every buffered request has been answered.
+    client.queueResponse(response);
 }
 
-Response Server::generateResponse(const Request& request, const Config& config) {
-    // TODO: Get relevant config block based on Host header and port
-    // Hardcoded for default.conf for now
-    std::string root = "./www/html"; // From default.conf root
-    std::vector<std::string> indexFiles;
-    indexFiles.push_back("index.html");
-    indexFiles.push_back("index.htm");
-    // std::string error404page = "/error_pages/404.html"; // Config lookup needed later
+// ETag and Last-Modified of a static file (also sent with its 304s)
+static void addValidators(Response& response, const FileLookup& lookup) {
+    if (!lookup.etag.empty()) {
+        response.setHeader(HEADER_ETAG, lookup.etag);
+    }
+    response.setHeader(HEADER_LAST_MODIFIED, lookup.lastModified);
+}
+
+// One element of an If-None-Match list equals etag under the weak comparison
+// (RFC 9110 8.8.3.2: the W/ prefix is ignored on both sides)
+static bool etagListMatches(const std::string& list, const std::string& etag) {
+    std::string opaque = etag.compare(0, 2, "W/") == 0 ? etag.substr(2) : etag;
+    std::string::size_type pos = 0;
+    while (pos < list.size()) {
+        std::string::size_type comma = list.find(',', pos);
+        std::string::size_type end = comma == std::string::npos ? list.size() : comma;
+        std::string::size_type first = list.find_first_not_of(" \t", pos);
+        std::string::size_type last = list.find_last_not_of(" \t", end - 1);
+        if (first != std::string::npos && first < end && last >= first) {
+            std::string candidate = list.substr(first, last - first + 1);
+            if (candidate == "*") {
+                return true;
+            }
+            if (candidate.compare(0, 2, "W/") == 0) {
+                candidate.erase(0, 2);
+            }
+            if (candidate == opaque) {
+                return true;
+            }
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
+// Accept-Encoding (RFC 9110 12.5.3) lists coding, or "*", with a non-zero q-value
+static bool acceptsEncoding(const Request& request, const char* coding) {
+    if (!request.findHeader(HEADER_ACCEPT_ENCODING)) {
+        return false; // No preference stated: send the identity encoding
+    }
+    std::string header = request.getHeader(HEADER_ACCEPT_ENCODING);
+    bool wildcard = false;
+    std::string::size_type pos = 0;
+    while (pos < header.size()) {
+        std::string::size_type comma = header.find(',', pos);
+        std::string element = header.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = comma == std::string::npos ? header.size() : comma + 1;
+
+        std::string::size_type semicolon = element.find(';');
+        std::string name = element.substr(0, semicolon);
+        std::string::size_type first = name.find_first_not_of(" \t");
+        if (first == std::string::npos) {
+            continue;
+        }
+        name = name.substr(first, name.find_last_not_of(" \t") - first + 1);
+        double q = 1.0;
+        if (semicolon != std::string::npos) {
+            std::string::size_type qpos = element.find("q=", semicolon);
+            if (qpos != std::string::npos) {
+                q = strtod(element.c_str() + qpos + 2, NULL);
+            }
+        }
+        if (strcasecmp(name.c_str(), coding) == 0) {
+            return q > 0; // An explicit entry wins over "*"
+        }
+        if (name == "*") {
+            wildcard = q > 0;
+        }
+    }
+    return wildcard;
+}
+
+// Types worth compressing: text and scripts (images are compressed already)
+static bool isCompressible(const std::string& contentType) {
+    return contentType.compare(0, 5, "text/") == 0 || contentType == "application/javascript";
+}
+
+// gzip-wrapped deflate of in into out (zlib, default level)
+#define GZIP_CHUNK static_cast<size_t>(1 << 30) // Most bytes handed to one deflate() call
+
+static bool gzipCompress(const std::string& in, std::string& out) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // windowBits 15 + 16: gzip header and trailer instead of the zlib ones
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out.resize(deflateBound(&stream, in.size()) + 32);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    int result = Z_OK;
+    while (result == Z_OK) {
+        // avail_in/avail_out are 32-bit: hand buffers over in pieces instead of truncating
+        size_t inLeft = in.size() - stream.total_in;
+        size_t outLeft = out.size() - stream.total_out;
+        stream.avail_in = static_cast<uInt>(std::min(inLeft, GZIP_CHUNK));
+        stream.avail_out = static_cast<uInt>(std::min(outLeft, GZIP_CHUNK));
+        result = deflate(&stream, stream.avail_in == inLeft ? Z_FINISH : Z_NO_FLUSH);
+    }
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+#define MAX_RANGES 16 // Range headers with more ranges than this are ignored (full 200)
+
+struct ByteRange {
+    size_t first;
+    size_t last; // Inclusive
+};
+
+// Parse a run of decimal digits; false if it is empty or not all digits. A value too large
+// for size_t saturates to SIZE_MAX (still a valid position, just past the end of any file).
+static bool parseRangeNumber(const std::string& digits, size_t& value) {
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < digits.size(); ++i) {
+        size_t digit = static_cast<size_t>(digits[i] - '0');
+        if (value > (static_cast<size_t>(-1) - digit) / 10) {
+            value = static_cast<size_t>(-1); // Saturate: such a position is past any file
+            continue;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+// Parse "bytes=0-99, 200-, -50" (RFC 9110 14.1.2) against a representation of size bytes.
+// Returns 206 with the satisfiable ranges, 416 if none is, or 200 to ignore the
+// header (other unit, bad syntax, too many ranges).
+static int parseRange(const std::string& value, size_t size, std::vector<ByteRange>& ranges) {
+    if (value.size() < 6 || strncasecmp(value.c_str(), "bytes=", 6) != 0) {
+        return 200;
+    }
+    std::string::size_type pos = 6;
+    size_t specs = 0;
+    while (pos <= value.size()) {
+        std::string::size_type comma = value.find(',', pos);
+        std::string::size_type end = comma == std::string::npos ? value.size() : comma;
+        std::string::size_type first = value.find_first_not_of(" \t", pos);
+        std::string spec;
+        if (first != std::string::npos && first < end) {
+            spec = value.substr(first, value.find_last_not_of(" \t", end - 1) - first + 1);
+        }
+        pos = end + 1;
+        if (spec.empty()) {
+            continue; // Empty list element
+        }
+        if (++specs > MAX_RANGES) {
+            return 200;
+        }
+        std::string::size_type dash = spec.find('-');
+        if (dash == std::string::npos) {
+            return 200;
+        }
+        size_t start = 0;
+        size_t stop = 0;
+        if (dash == 0) {
+            // Suffix range: the last N bytes
+            if (!parseRangeNumber(spec.substr(1), stop)) {
+                return 200;
+            }
+            if (stop > 0 && size > 0) {
+                ByteRange range = { stop >= size ? 0 : size - stop, size - 1 };
+                ranges.push_back(range);
+            }
+            continue;
+        }
+        if (!parseRangeNumber(spec.substr(0, dash), start)) {
+            return 200;
+        }
+        if (dash + 1 == spec.size()) {
+            stop = static_cast<size_t>(-1); // "N-": to the end
+        } else if (!parseRangeNumber(spec.substr(dash + 1), stop) || stop < start) {
+            return 200;
+        }
+        if (start < size) {
+            ByteRange range = { start, stop < size ? stop : size - 1 };
+            ranges.push_back(range);
+        }
+    }
+    if (specs == 0) {
+        return 200;
+    }
+    return ranges.empty() ? 416 : 206;
+}
+
+// If-Range (RFC 9110 13.1.5): the Range applies only if the representation is
+// unchanged, judged by a strong ETag match or the exact Last-Modified date
+static bool ifRangeMatches(const Request& request, const FileLookup& lookup) {
+    if (!request.findHeader(HEADER_IF_RANGE)) {
+        return true;
+    }
+    std::string value = request.getHeader(HEADER_IF_RANGE);
+    if (!value.empty() && (value[0] == '"' || value.compare(0, 2, "W/") == 0)) {
+        return !lookup.etag.empty() && lookup.etag[0] == '"' && value == lookup.etag; // Strong comparison
+    }
+    time_t date;
+    return HttpDate::parse(value, date) && date == lookup.mtime;
+}
+
+// 206 Partial Content straight from the file: one range as the body, several as
+// multipart/byteranges with each part's headers in memory and its data sent with sendfile()
+static Response rangeResponse(const FileLookup& lookup, const std::vector<ByteRange>& ranges, uint64_t seed) {
+    const std::shared_ptr<OpenFile>& file = lookup.file;
+    std::string total = "/" + std::to_string(file->size);
+    Response response;
+    response.setStatusCode(206);
+    addValidators(response, lookup);
+    response.setHeader(HEADER_ACCEPT_RANGES, "bytes");
+    if (ranges.size() == 1) {
+        response.setHeader(HEADER_CONTENT_TYPE, lookup.contentType);
+        response.setHeader(HEADER_CONTENT_RANGE, "bytes " + std::to_string(ranges[0].first) + "-"
+                           + std::to_string(ranges[0].last) + total);
+        response.setBodyFile(file, static_cast<off_t>(ranges[0].first), ranges[0].last - ranges[0].first + 1);
+        std::cout << "-> Returning 206 (bytes " << ranges[0].first << "-" << ranges[0].last << ")" << std::endl;
+        return response;
+    }
+
+    // Boundary: 16 hex digits mixed from the file identity and the time (splitmix64)
+    uint64_t mix = seed ^ (static_cast<uint64_t>(file->mtime) << 20) ^ file->size;
+    mix = (mix ^ (mix >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    mix = (mix ^ (mix >> 27)) * 0x94d049bb133111ebULL;
+    mix ^= mix >> 31;
+    char boundary[17];
+    snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(mix));
+
+    response.setHeader(HEADER_CONTENT_TYPE, std::string("multipart/byteranges; boundary=") + boundary);
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        response.addBodyPart(std::string(i == 0 ? "" : "\r\n") + "--" + boundary + "\r\n"
+                             + "Content-Type: " + lookup.contentType + "\r\n"
+                             + "Content-Range: bytes " + std::to_string(ranges[i].first) + "-"
+                             + std::to_string(ranges[i].last) + total + "\r\n\r\n");
+        response.addBodyPart(file, static_cast<off_t>(ranges[i].first), ranges[i].last - ranges[i].first + 1);
+    }
+    response.addBodyPart(std::string("\r\n--") + boundary + "--\r\n");
+    std::cout << "-> Returning 206 (" << ranges.size() << " ranges, multipart/byteranges)" << std::endl;
+    return response;
+}
+
+// RFC 9110 13.2.2: If-None-Match takes precedence; If-Modified-Since is only
+// looked at without it, and ignored unless it is a valid HTTP-date
+bool Server::isNotModified(const Request& request, const FileLookup& lookup) const {
+    if (request.findHeader(HEADER_IF_NONE_MATCH)) {
+        return !lookup.etag.empty() && etagListMatches(request.getHeader(HEADER_IF_NONE_MATCH), lookup.etag);
+    }
+    if (request.findHeader(HEADER_IF_MODIFIED_SINCE)) {
+        time_t since;
+        if (HttpDate::parse(request.getHeader(HEADER_IF_MODIFIED_SINCE), since)) {
+            return lookup.mtime <= since;
+        }
+    }
+    return false;
+}
+
+Response Server::generateResponse(const Request& request, const Config& config, size_t server) {
+    std::string root = config.getRoot(server);
 
     Response response;
     response.setVersion("HTTP/1.1");
@@ -353,25 +1146,306 @@ Response Server::generateResponse(const Request& request, const Config& config)
 
     if (request.getMethod() != "GET") {
         std::cout << "-> Method Not Allowed" << std::endl;
-        return generateErrorResponse(405, config);
+        return generateErrorResponse(405, config, server);
     }
 
     std::string requestedPath = request.getPath();
     if (requestedPath.find("..") != std::string::npos) {
         std::cout << "-> Directory Traversal Attempt" << std::endl;
-        return generateErrorResponse(400, config);
+        return generateErrorResponse(400, config, server);
     }
     if (requestedPath.empty() || requestedPath[0] != '/') {
          requestedPath = "/" + requestedPath;
     }
-
-    // Ensure root path does not end with '/' for clean joining, unless root is "/"
-    if (root.length() > 1 && root[root.length() - 1] == '/') {
-         root.pop_back();
+    // Merge duplicate slashes so every spelling of a path shares one open_file_cache entry
+    for (std::string::size_type slash = requestedPath.find("//"); slash != std::string::npos;
+         slash = requestedPath.find("//", slash)) {
+        requestedPath.erase(slash, 1);
     }
-    // Ensure requested path starts with '/' (already done)
 
     std::string fullPath = root + requestedPath;
+
+    FileLookup resolved;
+    const FileLookup* lookup = lookupStaticFile(fullPath, resolved);
+    if (lookup->status != 200) {
+        return generateErrorResponse(lookup->status, config, server);
+    }
+
+    // Content negotiation: text types may go out compressed, so every response for them varies (304s too)
+    bool vary = (config.getGzipStatic() || config.getGzip()) && isCompressible(lookup->contentType);
+
+    // Revalidation: answered from the validators alone, before the file is ever opened
+    if (isNotModified(request, *lookup)) {
+        std::cout << "-> Returning 304 Not Modified" << std::endl;
+        response.setStatusCode(304);
+        addValidators(response, *lookup);
+        if (vary) {
+            response.setHeader(HEADER_VARY, "Accept-Encoding");
+        }
+        return response;
+    }
+    // Range requests: sent from the file offset, never through the response cache
+    if (request.findHeader(HEADER_RANGE) && ifRangeMatches(request, *lookup)) {
+        if (!lookup->file && !openStaticFile(fullPath, resolved)) {
+            return generateErrorResponse(500, config, server);
+        }
+        std::vector<ByteRange> ranges;
+        int rangeStatus = parseRange(request.getHeader(HEADER_RANGE), lookup->file->size, ranges);
+        if (rangeStatus == 416) {
+            // Built rather than sent from _errorPages: the prebuilt blob has no Content-Range
+            Response unsatisfiable = _errorPages.build(server, 416);
+            unsatisfiable.setHeader(HEADER_CONTENT_RANGE, "bytes */" + std::to_string(lookup->file->size));
+            return unsatisfiable;
+        }
+        if (rangeStatus == 206) {
+            Response partial = rangeResponse(*lookup, ranges, _nowMs);
+            if (vary) {
+                partial.setHeader(HEADER_VARY, "Accept-Encoding");
+            }
+            return partial;
+        }
+    }
+    std::cout << "-> Content-Type: " << lookup->contentType << std::endl;
+
+    FileLookup original;
+    if (vary && config.getGzipStatic()) {
+        // Sibling lookups insert into the open_file_cache, which may evict the entry lookup points to
+        if (lookup != &resolved) {
+            original = *lookup;
+            lookup = &original;
+        }
+        // A precompressed sibling, used only if it is at least as new as the file itself
+        static const char* const codings[] = { "br", "gzip" };
+        static const char* const suffixes[] = { ".br", ".gz" };
+        for (size_t i = 0; i < 2; ++i) {
+            if (!acceptsEncoding(request, codings[i])) {
+                continue;
+            }
+            FileLookup siblingScratch;
+            const FileLookup* sibling = lookupStaticFile(lookup->path + suffixes[i], siblingScratch);
+            if (sibling->status != 200 || sibling->mtime < lookup->mtime) {
+                continue;
+            }
+            std::cout << "-> gzip_static: " << sibling->path << std::endl;
+            if (isNotModified(request, *sibling)) {
+                std::cout << "-> Returning 304 Not Modified" << std::endl;
+                response.setStatusCode(304);
+                addValidators(response, *sibling);
+                response.setHeader(HEADER_VARY, "Accept-Encoding");
+                return response;
+            }
+            if (!sibling->file && !openStaticFile(lookup->path + suffixes[i], siblingScratch)) {
+                return generateErrorResponse(500, config, server);
+            }
+            return fileResponse(*sibling, lookup->contentType, fullPath, codings[i], true, server);
+        }
+    }
+    // Only a fresh resolution (lookup == &resolved) is still unopened
+    if (!lookup->file && !openStaticFile(fullPath, resolved)) {
+        return generateErrorResponse(500, config, server);
+    }
+    // Compressed synchronously in the event loop: bounded by gzip_max_length, larger files go out as they are
+    if (vary && config.getGzip() && lookup->file->size >= config.getGzipMinLength()
+        && lookup->file->size <= config.getGzipMaxLength() && acceptsEncoding(request, "gzip")) {
+        return gzipResponse(*lookup, fullPath, server);
+    }
+    return fileResponse(*lookup, lookup->contentType, fullPath, NULL, vary, server);
+}
+
+// Hot path: one open_file_cache lookup. Otherwise stat/index the path into scratch:
+// a 403/404 is remembered at once, a 200 once openStaticFile() has its descriptor
+// (a revalidation answered with 304 never opens the file).
+const FileLookup* Server::lookupStaticFile(const std::string& path, FileLookup& scratch) {
+    const FileLookup* lookup = _fileCache.find(path, _nowMs);
+    if (lookup) {
+        return lookup;
+    }
+    scratch = resolveStaticFile(path);
+    if (scratch.status != 200) {
+        _fileCache.insert(path, scratch, _nowMs);
+    }
+    return &scratch;
+}
+
+// Validators of the resolved file, from stat() before it is opened and again from fstat() after
+static void setValidators(FileLookup& lookup, const struct stat& st, const std::string& etagMode) {
+    lookup.mtime = st.st_mtime;
+    lookup.lastModified = HttpDate::format(st.st_mtime);
+    if (etagMode != "off") {
+        // Changes whenever the file is replaced (inode), rewritten (size) or touched (mtime)
+        char etag[80];
+        snprintf(etag, sizeof(etag), "%s\"%lx-%llx-%llx\"", etagMode == "weak" ? "W/" : "",
+                 static_cast<unsigned long>(st.st_ino), static_cast<unsigned long long>(st.st_size),
+                 static_cast<unsigned long long>(st.st_mtime));
+        lookup.etag = etag;
+    }
+}
+
+// A body is going to be sent from a fresh resolution: open it and remember it under path.
+// False if it can't be opened (not cached: EMFILE and the like are transient).
+bool Server::openStaticFile(const std::string& path, FileLookup& lookup) {
+    std::cout << "-> Opening file: " << lookup.path << std::endl;
+    int fileFd = open(lookup.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileFd < 0) {
+        // Use errno to understand why opening failed
+        std::cerr << "Error: Failed to open file '" << lookup.path << "': " << strerror(errno) << std::endl;
+        std::cout << "-> Returning 500 (cannot open file)" << std::endl;
+        return false;
+    }
+    // fstat the descriptor itself: the size we announce must be the size of what we send
+    struct stat file_stat;
+    if (fstat(fileFd, &file_stat) != 0) {
+        perror("fstat failed");
+        close(fileFd);
+        return false;
+    }
+    lookup.file.reset(new OpenFile(fileFd, static_cast<size_t>(file_stat.st_size), file_stat.st_mtime));
+    setValidators(lookup, file_stat, _config.getEtag()); // The file may have changed since the stat()
+    _fileCache.insert(path, lookup, _nowMs);
+    return true;
+}
+
+// Read a whole (small) file with pread(), which leaves the shared descriptor's offset alone
+static bool readWholeFile(const OpenFile& file, std::string& body) {
+    body.assign(file.size, '\0');
+    size_t total = 0;
+    while (total < body.size()) {
+        ssize_t bytesRead = pread(file.fd, &body[total], body.size() - total, total);
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            return false;
+        }
+        total += static_cast<size_t>(bytesRead);
+    }
+    return true;
+}
+
+// 200 OK for a static file sent as it is stored: the file itself, or a
+// precompressed sibling (encoding "br"/"gzip") standing in for requestPath
+Response Server::fileResponse(const FileLookup& source, const std::string& contentType,
+                              const std::string& requestPath, const char* encoding, bool vary, size_t server) {
+    const std::shared_ptr<OpenFile>& file = source.file;
+    Response response;
+
+    // Small file: the whole serialized response may already be cached
+    bool cacheable = _responseCache.isEnabled() && file->size < _config.getSendfileThreshold();
+    std::string cacheKey;
+    if (cacheable) {
+        cacheKey = ResponseCache::makeKey(server, requestPath, encoding ? encoding : "identity");
+        CachedResponse cached;
+        if (_responseCache.find(cacheKey, file, cached)) {
+            response.setStatusCode(200);
+            response.setCached(cached);
+            return response;
+        }
+    }
+
+    // Build the 200 OK response
+    response.setStatusCode(200);
+    response.setHeader(HEADER_CONTENT_TYPE, contentType);
+    response.setHeader(HEADER_CONTENT_LENGTH, std::to_string(file->size));
+    if (encoding) {
+        response.setHeader(HEADER_CONTENT_ENCODING, encoding);
+    }
+    if (vary) {
+        response.setHeader(HEADER_VARY, "Accept-Encoding");
+    }
+    addValidators(response, source);
+    if (!encoding) {
+        response.setHeader(HEADER_ACCEPT_RANGES, "bytes"); // Ranges are only served from the identity encoding
+    }
+
+    if (file->size >= _config.getSendfileThreshold()) {
+        // Large file: the body goes from the page cache to the socket with sendfile()
+        // (with completion I/O, in FILE_READ_CHUNK reads and sends through the ring)
+        std::cout << "-> Sending " << file->size << " bytes with " << (_completionIo ? "ring reads" : "sendfile()")
+                  << "." << std::endl;
+        response.setBodyFile(file, 0, file->size);
+    } else {
+        // Small file: one read() straight into the body (a separate sendfile() call would cost more)
+        std::string body;
+        if (!readWholeFile(*file, body)) {
+            std::cerr << "Error reading file: " << source.path << std::endl;
+            std::cout << "-> Returning 500 (file read error)" << std::endl;
+            return generateErrorResponse(500, _config, server);
+        }
+        std::cout << "-> Read " << body.length() << " bytes from file." << std::endl;
+        response.setBody(std::move(body));
+        if (cacheable) {
+            _responseCache.insert(cacheKey, file, response.toCacheableString());
+        }
+    }
+
+    std::cout << "-> Returning 200 OK" << std::endl;
+    std::cout << "--------------------------" << std::endl;
+    return response;
+}
+
+// 200 OK with the file gzip-compressed by zlib. The serialized result goes into
+// the gzip cache, so a file is compressed once per change, not once per request.
+Response Server::gzipResponse(const FileLookup& lookup, const std::string& requestPath, size_t server) {
+    const std::shared_ptr<OpenFile>& file = lookup.file;
+    Response response;
+    std::string cacheKey = ResponseCache::makeKey(server, requestPath, "gzip");
+    CachedResponse cached;
+    if (_gzipCache.find(cacheKey, file, cached)) {
+        response.setStatusCode(200);
+        response.setCached(cached);
+        return response;
+    }
+
+    std::string body;
+    std::string compressed;
+    if (!readWholeFile(*file, body) || !gzipCompress(body, compressed)) {
+        std::cerr << "Error compressing file: " << lookup.path << std::endl;
+        std::cout << "-> Returning 500 (gzip failed)" << std::endl;
+        return generateErrorResponse(500, _config, server);
+    }
+    std::cout << "-> gzip: " << body.size() << " -> " << compressed.size() << " bytes" << std::endl;
+
+    response.setStatusCode(200);
+    response.setHeader(HEADER_CONTENT_TYPE, lookup.contentType);
+    response.setHeader(HEADER_CONTENT_LENGTH, std::to_string(compressed.size()));
+    response.setHeader(HEADER_CONTENT_ENCODING, "gzip");
+    response.setHeader(HEADER_VARY, "Accept-Encoding");
+    if (!lookup.etag.empty()) {
+        // Not byte-identical to the stored file: the validator can only be weak
+        response.setHeader(HEADER_ETAG, lookup.etag[0] == 'W' ? lookup.etag : "W/" + lookup.etag);
+    }
+    response.setHeader(HEADER_LAST_MODIFIED, lookup.lastModified);
+    response.setBody(std::move(compressed));
+    _gzipCache.insert(cacheKey, file, response.toCacheableString());
+    std::cout << "-> Returning 200 OK (gzip)" << std::endl;
+    std::cout << "--------------------------" << std::endl;
+    return response;
+}
+
+// Content-Type from the file extension
+static const char* contentTypeFor(const std::string& path) {
+    size_t dotPos = path.find_last_of('.');
+    if (dotPos != std::string::npos && path.find('/', dotPos) == std::string::npos) {
+        std::string ext = path.substr(dotPos);
+        if (ext == ".html" || ext == ".htm") return "text/html";
+        if (ext == ".css") return "text/css";
+        if (ext == ".js") return "application/javascript";
+        if (ext == ".jpg" || ext == ".jpeg") return "image/jpeg";
+        if (ext == ".png") return "image/png";
+        if (ext == ".txt") return "text/plain";
+    }
+    return "application/octet-stream";
+}
+
+// The filesystem side of a static request: stat the path and apply the index files to
+// a directory. Only runs on an open_file_cache miss; openStaticFile() opens the result.
+FileLookup Server::resolveStaticFile(const std::string& path) {
+    std::vector<std::string> indexFiles;
+    indexFiles.push_back("index.html");
+    indexFiles.push_back("index.htm");
+
+    FileLookup lookup;
+    std::string fullPath = path;
     std::cout << "Checking full path: " << fullPath << std::endl;
 
     struct stat path_stat;
@@ -379,7 +1453,8 @@ Response Server::generateResponse(const Request& request, const Config& config)
         // Use perror to print the system error message for stat failure
         perror(("-> stat failed for: " + fullPath).c_str());
         std::cout << "-> Returning 404 (stat failed)" << std::endl;
-        return generateErrorResponse(404, config);
+        lookup.status = 404;
+        return lookup;
     }
 
     std::string resolvedPath = fullPath; // Path to the actual file/dir
@@ -387,6 +1462,7 @@ Response Server::generateResponse(const Request& request, const Config& config)
     // If it's a directory
     if (S_ISDIR(path_stat.st_mode)) {
         std::cout << "-> Path is a directory: " << fullPath << std::endl;
+        lookup.isDirectory = true;
         // Ensure directory path ends with '/' for correct index joining
         if (fullPath[fullPath.length() - 1] != '/') {
             fullPath += "/";
@@ -413,7 +1489,6 @@ Response Server::generateResponse(const Request& request, const Config& config)
                 }
             } else {
                  // Don't generate error here, just means this index file doesn't exist
-                 // perror(("   -> stat failed for index: " + potentialIndexPath).c_str());
                  std::cout << "   -> Index file not found or stat failed." << std::endl;
             }
         }
@@ -421,7 +1496,8 @@ Response Server::generateResponse(const Request& request, const Config& config)
             // TODO: Implement directory listing based on config (autoindex on;)
             std::cout << "-> No suitable index file found and autoindex off." << std::endl;
             std::cout << "-> Returning 404 (no index)" << std::endl; // Changed from 403
-            return generateErrorResponse(404, config);
+            lookup.status = 404;
+            return lookup;
         }
         // If index found, resolvedPath now points to the index file
          std::cout << "-> Resolved path to index file: " << resolvedPath << std::endl;
@@ -431,106 +1507,42 @@ Response Server::generateResponse(const Request& request, const Config& config)
     else if (!S_ISREG(path_stat.st_mode)) {
          std::cout << "-> Path is not a regular file: " << resolvedPath << std::endl;
          std::cout << "-> Returning 403 (not regular file)" << std::endl;
-        return generateErrorResponse(403, config); // Forbidden
+        lookup.status = 403; // Forbidden
+        return lookup;
     }
 
     // At this point, resolvedPath points to a valid regular file.
-    std::cout << "-> Attempting to serve file: " << resolvedPath << std::endl;
-    std::ifstream fileStream(resolvedPath.c_str(), std::ios::binary);
-    if (!fileStream.is_open()) {
-        // Use errno to understand why opening failed
-        std::cerr << "Error: Failed to open file '" << resolvedPath << "': " << strerror(errno) << std::endl;
-        std::cout << "-> Returning 500 (cannot open file)" << std::endl;
-        return generateErrorResponse(500, config);
-    }
-
-    // Determine Content-Type
-    std::string contentType = "application/octet-stream";
-    size_t dotPos = resolvedPath.find_last_of('.');
-    if (dotPos != std::string::npos) {
-        std::string ext = resolvedPath.substr(dotPos);
-        if (ext == ".html" || ext == ".htm") contentType = "text/html";
-        else if (ext == ".css") contentType = "text/css";
-        else if (ext == ".js") contentType = "application/javascript";
-        else if (ext == ".jpg" || ext == ".jpeg") contentType = "image/jpeg";
-        else if (ext == ".png") contentType = "image/png";
-        else if (ext == ".txt") contentType = "text/plain";
-    }
-     std::cout << "-> Content-Type: " << contentType << std::endl;
-
-    // Read file content
-    std::ostringstream contentStream;
-    contentStream << fileStream.rdbuf();
-     if (fileStream.fail() && !fileStream.eof()) {
-         std::cerr << "Error reading file stream for: " << resolvedPath << std::endl;
-         std::cout << "-> Returning 500 (file read error)" << std::endl;
-         return generateErrorResponse(500, config);
-     }
-    std::string body = contentStream.str();
-    fileStream.close(); // Close the stream
-
-    std::cout << "-> Read " << body.length() << " bytes from file." << std::endl;
-
-    // Build the 200 OK response
-    response.setStatusCode(200);
-    response.setHeader("Content-Type", contentType);
-    response.setHeader("Content-Length", std::to_string(body.length()));
-    response.setHeader("Connection", "close");
-    response.setBody(body);
-
-    std::cout << "-> Returning 200 OK" << std::endl;
-    std::cout << "--------------------------" << std::endl;
-    return response;
+    lookup.status = 200;
+    lookup.path = resolvedPath;
+    lookup.contentType = contentTypeFor(resolvedPath);
+    setValidators(lookup, path_stat, _config.getEtag());
+    return lookup;
 }
 
-Response Server::generateErrorResponse(int statusCode, const Config& /*config*/) { // <-- Commented out name
-    // TODO: Use config to find custom error pages (e.g., from default.conf error_page 404)
-    std::string errorPagePath;
-    // if (config.hasErrorPage(statusCode)) { errorPagePath = config.getErrorPage(statusCode); }
-
-    std::string body;
-    std::string statusMessage;
-    bool customPageFound = false;
-
-    // Simplified status messages
-    switch (statusCode) {
-        case 400: statusMessage = "Bad Request"; break;
-        case 403: statusMessage = "Forbidden"; break;
-        case 404: statusMessage = "Not Found"; break;
-        case 405: statusMessage = "Method Not Allowed"; break;
-        case 500: statusMessage = "Internal Server Error"; break;
-        default:  statusMessage = "Error"; statusCode = 500; // Default unknown errors to 500
-    }
-
-    // TODO: Try to load custom error page from errorPagePath if set
-    // if (!errorPagePath.empty()) { ... try stat/ifstream ... customPageFound = true; }
-
-    if (!customPageFound) {
-        // Generate default HTML error page
-        std::ostringstream oss;
-        oss << "<html><head><title>" << statusCode << " " << statusMessage << "</title></head>"
-            << "<body><h1>" << statusCode << " " << statusMessage << "</h1>"
-            << "<p>Error processing request.</p><hr><p>webserv</p></body></html>";
-        body = oss.str();
+Response Server::generateErrorResponse(int statusCode, const Config& /*config*/, size_t server) { // <-- Commented out name
+    if (!ErrorPages::isErrorCode(statusCode)) {
+        statusCode = 500; // Default unknown errors to 500
     }
 
+    // Prebuilt at startup: the serialized response is sent by reference
     Response response;
-    response.setVersion("HTTP/1.1");
-    response.setStatusCode(statusCode, statusMessage);
-    response.setHeader("Content-Type", "text/html");
-    response.setHeader("Content-Length", std::to_string(body.length()));
-    response.setHeader("Connection", "close"); // Errors usually close connection
-    response.setBody(body);
+    CachedResponse cached;
+    if (_errorPages.find(server, statusCode, cached)) {
+        response.setStatusCode(statusCode);
+        response.setCached(cached);
+    } else {
+        response = _errorPages.build(server, statusCode);
+    }
 
-    std::cerr << "Generated Error Response: " << statusCode << " " << statusMessage << std::endl;
+    std::cerr << "Generated Error Response: " << statusCode << " " << Response::getDefaultStatusMessage(statusCode) << std::endl;
 
     return response;
 }
 
-void Server::handleClientDisconnection(int clientFd, bool isError) {
-    std::map<int, Client>::iterator it = _clients.find(clientFd);
-    if (it == _clients.end()) {
-        // Already disconnected or never existed
+void Server::handleClientDisconnection(Client& client, bool isError) {
+    int clientFd = client.getFd();
+    if (clientFd < 0) {
+        // Already disconnected
         return;
     }
 
@@ -540,22 +1552,103 @@ void Server::handleClientDisconnection(int clientFd, bool isError) {
         // std::cout << "Handling disconnection for client fd=" << clientFd << std::endl;
     }
 
-    removeSocketFromEpoll(clientFd); // Remove from epoll interest list
-    close(clientFd);                 // Close the socket file descriptor
-    _clients.erase(it);              // Remove the Client object from the map
+    _timers.cancel(&client.getTimer());
+    _bufferedBytes -= client.getAccountedBytes();
+    client.setAccountedBytes(0);
+    client.returnBuffers(_bufferPool);
+    --_activeClients;
+    if (_completionIo) {
+        // The queued responses and the file chunk stay in the slot until the
+        // cancelled operations report back (handleCompletion frees it then)
+        _poller->cancelAndClose(clientFd);
+        if (client.getPendingOperations() > 0) {
+            client.markClosed();
+            ++_closingClients;
+            return;
+        }
+    } else {
+        removeSocketFromPoller(clientFd); // Remove from poller interest list
+        close(clientFd);                 // Close the socket file descriptor
+    }
+    releaseClientSlot(client);
+}
+
+void Server::releaseClientSlot(Client& client) {
+    client = Client();               // Reset the slot (fd = -1 marks it free for stale events)
+    _releasedClients.push_back(&client);
+}
+
+uint64_t Server::monotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
 }
 
-// Add helper to modify existing epoll registration
-void Server::modifySocketInEpoll(int fd, uint32_t events) {
-    struct epoll_event event;
-    event.data.fd = fd;
-    event.events = events; // e.g., EPOLLIN | EPOLLOUT | EPOLLET
-    if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &event) < 0) {
-        perror("epoll_ctl(MOD) failed");
+// Pick the timeout for the phase the client is in and (re)arm its timer.
+// The header and keep-alive deadlines are absolute, so they are not pushed back
+// by further reads; body and send timeouts measure the gap between I/O progress.
+void Server::refreshClientTimer(Client& client) {
+    ClientTimeout kind = TIMEOUT_NONE;
+    unsigned long timeoutMs = 0;
+
+    if (client.getState() == SENDING_RESPONSE) {
+        kind = TIMEOUT_SEND;
+        timeoutMs = _config.getSendTimeoutMs();
+    } else if (client.getState() == AWAITING_REQUEST) {
+        if (client.hasCompleteHeaders()) {
+            kind = TIMEOUT_BODY;
+            timeoutMs = _config.getClientBodyTimeoutMs();
+        } else if (client.getRawRequest().empty() && client.getRequestCount() > 0) {
+            kind = TIMEOUT_KEEPALIVE;
+            timeoutMs = _config.getKeepaliveTimeoutMs();
+        } else {
+            kind = TIMEOUT_HEADER;
+            timeoutMs = _config.getClientHeaderTimeoutMs();
+        }
+    }
+
+    if ((kind == TIMEOUT_HEADER || kind == TIMEOUT_KEEPALIVE) && client.getTimeoutKind() == kind) {
+        return; // Deadline already running
+    }
+    if (kind == TIMEOUT_NONE || timeoutMs == 0) {
+        _timers.cancel(&client.getTimer());
+        client.setTimeoutKind(TIMEOUT_NONE);
+        return;
+    }
+    _timers.arm(&client.getTimer(), timeoutMs, _nowMs);
+    client.setTimeoutKind(kind);
+}
+
+void Server::expireTimers() {
+    _expiredTimers.clear();
+    _timers.advance(_nowMs, _expiredTimers);
+    for (size_t i = 0; i < _expiredTimers.size(); ++i) {
+        Client& client = *static_cast<Client*>(_expiredTimers[i]->owner);
+        static const char* const names[] = { "none", "header", "body", "keepalive", "send" };
+        std::cout << "Client fd=" << client.getFd() << ": " << names[client.getTimeoutKind()]
+                  << " timeout, closing connection." << std::endl;
+        handleClientDisconnection(client);
+    }
+    recycleReleasedClients();
+}
+
+void Server::modifyClientInPoller(Client& client, uint32_t events) {
+    if (!_poller->modify(client.getFd(), events, &client)) {
         // This is often serious, maybe disconnect client?
-        handleClientDisconnection(fd, true); // Treat as error
+        handleClientDisconnection(client, true); // Treat as error
+    }
+}
+
+// EPOLLOUT stays registered only while responses are waiting, so an idle
+// keep-alive connection isn't woken for every writable transition.
+void Server::updateWriteInterest(Client& client) {
+    bool wanted = client.hasPendingOutput();
+    if (wanted == client.hasWriteInterest()) {
+        return;
     }
+    client.setWriteInterest(wanted);
+    modifyClientInPoller(client, wanted ? (EPOLLIN | EPOLLOUT | EPOLLET) : (EPOLLIN | EPOLLET));
 }
 
 // Implement other Server methods here (setupListeningSockets, etc.)
-// void Server::setupListeningSockets() { ... } // Needs config parsing 
\ No newline at end of file
+// void Server::setupListeningSockets() { ... } // Needs config parsing
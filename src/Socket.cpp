@@ -54,7 +54,7 @@ Socket& Socket::operator=(Socket&& other) noexcept {
 }
 
 // Initialize the socket: create, set options, bind, listen
-bool Socket::init(const std::string& host) {
+bool Socket::init(const std::string& host, bool reusePort) {
     // 1. Create socket
     _sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (_sockfd < 0) {
@@ -72,6 +72,13 @@ bool Socket::init(const std::string& host) {
     }
     // std::cout << "Socket option SO_REUSEADDR set." << std::endl;
 
+    // 2b. One listener per event loop: let the kernel spread connections across them
+    if (reusePort && setsockopt(_sockfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt(SO_REUSEPORT) failed");
+        closeSocket();
+        return false;
+    }
+
     // 3. Make socket non-blocking
     if (fcntl(_sockfd, F_SETFL, O_NONBLOCK) < 0) {
         perror("fcntl(O_NONBLOCK) failed");
@@ -110,6 +117,19 @@ bool Socket::init(const std::string& host) {
     return true;
 }
 
+// Adopt an already listening socket instead of creating/binding a new one
+bool Socket::adopt(int fd) {
+    socklen_t len = sizeof(_address);
+    if (getsockname(fd, (struct sockaddr*)&_address, &len) < 0) {
+        perror("getsockname failed on inherited socket");
+        return false;
+    }
+    closeSocket();
+    _sockfd = fd;
+    _port = ntohs(_address.sin_port);
+    return true;
+}
+
 // Close the socket
 void Socket::closeSocket() {
     if (_sockfd >= 0) {
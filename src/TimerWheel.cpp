@@ -0,0 +1,123 @@
+#include "TimerWheel.hpp"
+
+TimerWheel::TimerWheel() : _currentTick(0), _started(false), _count(0) {
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        for (int slot = 0; slot < TIMER_WHEEL_SIZE; ++slot) {
+            _slots[level][slot].prev = &_slots[level][slot];
+            _slots[level][slot].next = &_slots[level][slot];
+        }
+    }
+}
+
+// Link node into the slot matching its distance from the current tick
+void TimerWheel::insert(TimerNode* node) {
+    uint64_t delta = node->expires - _currentTick;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    if (level == TIMER_WHEEL_LEVELS - 1) {
+        // Clamp anything beyond the wheel's range to the furthest slot
+        uint64_t maxDelta = (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+        if (delta > maxDelta) {
+            node->expires = _currentTick + maxDelta;
+        }
+    }
+    int slot = static_cast<int>((node->expires >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SIZE - 1));
+    TimerNode* head = &_slots[level][slot];
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+void TimerWheel::arm(TimerNode* node, uint64_t timeoutMs, uint64_t nowMs) {
+    if (!_started) {
+        _currentTick = nowMs / TIMER_TICK_MS;
+        _started = true;
+    }
+    cancel(node);
+    // Round the deadline up to a tick boundary so a timer never fires early
+    node->expires = (nowMs + timeoutMs + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    if (node->expires <= _currentTick) {
+        node->expires = _currentTick + 1;
+    }
+    insert(node);
+    ++_count;
+}
+
+void TimerWheel::cancel(TimerNode* node) {
+    if (!node->isArmed()) {
+        return;
+    }
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+    --_count;
+}
+
+// Re-insert every node of the level's current slot one level down
+void TimerWheel::cascade(int level) {
+    int slot = static_cast<int>((_currentTick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SIZE - 1));
+    TimerNode* head = &_slots[level][slot];
+    TimerNode* node = head->next;
+    head->next = head;
+    head->prev = head;
+    while (node != head) {
+        TimerNode* next = node->next;
+        insert(node);
+        node = next;
+    }
+}
+
+void TimerWheel::advance(uint64_t nowMs, std::vector<TimerNode*>& expired) {
+    uint64_t targetTick = nowMs / TIMER_TICK_MS;
+    if (_count == 0 || !_started) {
+        // Nothing armed: jump straight to the present
+        _currentTick = targetTick;
+        _started = true;
+        return;
+    }
+    while (_currentTick < targetTick && _count > 0) {
+        ++_currentTick;
+        // When a level wraps, pull the next slot of the level above down into it
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+            if ((_currentTick & ((1ULL << (TIMER_WHEEL_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+        TimerNode* head = &_slots[0][_currentTick & (TIMER_WHEEL_SIZE - 1)];
+        while (head->next != head) {
+            TimerNode* node = head->next;
+            cancel(node);
+            expired.push_back(node);
+        }
+    }
+    if (_currentTick < targetTick) {
+        _currentTick = targetTick; // Wheel emptied before reaching now
+    }
+}
+
+int TimerWheel::nextTimeoutMs(uint64_t nowMs) const {
+    if (_count == 0) {
+        return -1;
+    }
+    // First non-empty level-0 slot ahead of us; otherwise the next level-0 wrap,
+    // where higher levels cascade down.
+    uint64_t ticksAhead = TIMER_WHEEL_SIZE - (_currentTick & (TIMER_WHEEL_SIZE - 1));
+    for (uint64_t i = 1; i < ticksAhead; ++i) {
+        const TimerNode* head = &_slots[0][(_currentTick + i) & (TIMER_WHEEL_SIZE - 1)];
+        if (head->next != head) {
+            ticksAhead = i;
+            break;
+        }
+    }
+    uint64_t dueMs = (_currentTick + ticksAhead) * TIMER_TICK_MS;
+    return dueMs > nowMs ? static_cast<int>(dueMs - nowMs) : 0;
+}
+
+size_t TimerWheel::size() const {
+    return _count;
+}
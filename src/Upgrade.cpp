@@ -0,0 +1,140 @@
+#include "Upgrade.hpp"
+#include <iostream>
+#include <sstream>    // For stringstream
+#include <cstdlib>    // For getenv, setenv, unsetenv, strtol
+#include <cstdio>     // For perror
+#include <cstring>    // For memset
+#include <csignal>    // For kill, SIGQUIT
+#include <unistd.h>   // For fork, execv, getppid, close, _exit
+#include <fcntl.h>    // For fcntl, FD_CLOEXEC
+#include <sys/socket.h> // For getsockopt, getsockname
+#include <netinet/in.h> // For sockaddr_in
+#include <arpa/inet.h>  // For inet_addr
+
+std::vector<std::string> Upgrade::_argv;
+std::vector<int> Upgrade::_inherited;
+bool Upgrade::_upgradeChild = false;
+pid_t Upgrade::_upgradePid = -1;
+
+void Upgrade::saveCommandLine(char* argv[]) {
+    _argv.clear();
+    for (int i = 0; argv[i] != NULL; ++i) {
+        _argv.push_back(argv[i]);
+    }
+}
+
+void Upgrade::loadInheritedListeners() {
+    const char* value = std::getenv(UPGRADE_LISTEN_FDS_ENV);
+    if (!value) {
+        return;
+    }
+    _upgradeChild = true;
+    _upgradePid = getpid();
+
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        if (item.empty()) {
+            continue;
+        }
+        char* end = NULL;
+        long fd = std::strtol(item.c_str(), &end, 10);
+        int listening = 0;
+        socklen_t len = sizeof(listening);
+        // Only trust fds that really are listening sockets
+        if (*end != '\0' || fd < 0
+            || getsockopt(static_cast<int>(fd), SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) < 0
+            || !listening) {
+            std::cerr << "Ignoring invalid inherited listener '" << item << "' in " << UPGRADE_LISTEN_FDS_ENV << std::endl;
+            continue;
+        }
+        _inherited.push_back(static_cast<int>(fd));
+    }
+    // Not for our own children (workers, or the binary of a later upgrade)
+    unsetenv(UPGRADE_LISTEN_FDS_ENV);
+    std::cout << "Binary upgrade: inherited " << _inherited.size() << " listening socket(s)." << std::endl;
+}
+
+int Upgrade::claimListener(const std::string& host, int port) {
+    for (size_t i = 0; i < _inherited.size(); ++i) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        std::memset(&addr, 0, sizeof(addr));
+        if (getsockname(_inherited[i], (struct sockaddr*)&addr, &len) < 0) {
+            continue;
+        }
+        if (addr.sin_addr.s_addr == inet_addr(host.c_str()) && ntohs(addr.sin_port) == port) {
+            int fd = _inherited[i];
+            _inherited.erase(_inherited.begin() + i);
+            std::cout << "Adopting inherited listener fd=" << fd << " for " << host << ":" << port << std::endl;
+            return fd;
+        }
+    }
+    return -1;
+}
+
+void Upgrade::closeUnclaimedListeners() {
+    for (size_t i = 0; i < _inherited.size(); ++i) {
+        std::cout << "Closing inherited listener fd=" << _inherited[i] << " (no longer configured)." << std::endl;
+        close(_inherited[i]);
+    }
+    _inherited.clear();
+}
+
+bool Upgrade::isUpgradeChild() {
+    return _upgradeChild;
+}
+
+void Upgrade::retireParent() {
+    if (!_upgradeChild || getpid() != _upgradePid) {
+        return; // Not an upgrade, or a worker forked by the new master
+    }
+    _upgradeChild = false; // Only once
+    pid_t parent = getppid();
+    if (parent <= 1) {
+        return; // Old process already gone
+    }
+    std::cout << "Binary upgrade: serving, asking old process (pid=" << parent << ") to drain." << std::endl;
+    if (kill(parent, SIGQUIT) < 0) {
+        perror("kill(SIGQUIT) of old process failed");
+    }
+}
+
+pid_t Upgrade::spawnNewBinary(const std::vector<int>& listenerFds) {
+    if (_argv.empty()) {
+        std::cerr << "Binary upgrade: command line unknown, cannot re-exec." << std::endl;
+        return -1;
+    }
+
+    std::ostringstream fds;
+    for (size_t i = 0; i < listenerFds.size(); ++i) {
+        fds << listenerFds[i] << ";";
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork for binary upgrade failed");
+        return -1;
+    }
+    if (pid == 0) {
+        // Child: keep the listeners across exec, everything else is close-on-exec already
+        for (size_t i = 0; i < listenerFds.size(); ++i) {
+            int flags = fcntl(listenerFds[i], F_GETFD);
+            if (flags >= 0) {
+                fcntl(listenerFds[i], F_SETFD, flags & ~FD_CLOEXEC);
+            }
+        }
+        setenv(UPGRADE_LISTEN_FDS_ENV, fds.str().c_str(), 1);
+
+        std::vector<char*> args;
+        for (size_t i = 0; i < _argv.size(); ++i) {
+            args.push_back(const_cast<char*>(_argv[i].c_str()));
+        }
+        args.push_back(NULL);
+        execv(args[0], &args[0]);
+        perror(("execv " + _argv[0] + " failed").c_str());
+        _exit(1);
+    }
+    std::cout << "Binary upgrade: started " << _argv[0] << " (pid=" << pid << ") with listeners " << fds.str() << std::endl;
+    return pid;
+}
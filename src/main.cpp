@@ -1,10 +1,52 @@
 #include <iostream>
 #include <string>
 #include <vector> // Include for future use if needed
+#include <thread> // For worker_threads mode
+#include <functional> // For std::ref
+#include <memory> // For std::unique_ptr
+#include <atomic> // For std::atomic
+#include <csignal> // For sigtimedwait
+#include <pthread.h> // For pthread_sigmask
 #include "Server.hpp"
+#include "Master.hpp"
+#include "Upgrade.hpp"
+#include "RequestBody.hpp"
 #include "Config.hpp" // Include Config header
 
+// Body of one worker thread: an independent Server (own epoll, clients and
+// SO_REUSEPORT listeners) running the usual single-threaded event loop.
+static void runWorker(Server& server, int workerId, std::atomic<int>& running) {
+    try {
+        server.run();
+    } catch (const std::exception& e) {
+        std::cerr << "Worker " << workerId << " error: " << e.what() << std::endl;
+    }
+    --running;
+}
+
+// worker_threads mode: the workers run with SIGQUIT/SIGUSR2 blocked and the main
+// thread takes them here, so a drain reaches every server rather than whichever
+// thread the kernel picked. Returns once every worker has left its event loop.
+static void superviseWorkers(std::vector<std::unique_ptr<Server> >& servers, const sigset_t& signals,
+                             const std::atomic<int>& running) {
+    bool draining = false;
+    while (running > 0) {
+        struct timespec timeout = { 1, 0 }; // Also notices workers that stopped on their own
+        int signum = sigtimedwait(&signals, NULL, &timeout);
+        if (signum == SIGQUIT && !draining) {
+            std::cout << "SIGQUIT: draining " << servers.size() << " worker threads." << std::endl;
+            draining = true;
+            for (size_t i = 0; i < servers.size(); ++i) {
+                servers[i]->requestDrain();
+            }
+        } else if (signum == SIGUSR2) {
+            std::cerr << "Binary upgrade ignored: not available with worker_threads (every thread binds its own listener)." << std::endl;
+        }
+    }
+}
+
 int main(int argc, char* argv[]) {
+    Upgrade::saveCommandLine(argv); // Re-executed as-is on SIGUSR2
     // Determine configuration file path
     std::string config_file;
     if (argc > 2) {
@@ -24,10 +66,47 @@ int main(int argc, char* argv[]) {
              std::cerr << "Error: Failed to load configuration file: " << config_file << std::endl;
              return 1;
         }
+        RequestBody::setTempDirectory(config.getClientBodyTempPath()); // Before any worker starts
 
-        // Create and run the server
-        Server server(config);
-        server.run();
+        int workerThreads = config.getWorkerThreads();
+        if (config.getWorkerProcesses() > 0) {
+            // Pre-fork mode: master binds listeners, forks and supervises worker processes
+            if (workerThreads > 1) {
+                std::cerr << "Warning: worker_threads is ignored when worker_processes is set." << std::endl;
+            }
+            Upgrade::loadInheritedListeners();
+            Master master(config);
+            master.run();
+        } else if (workerThreads > 1) {
+            // Multi-reactor mode: one event loop per thread, nothing shared but the (read-only) config.
+            // Each thread binds its own SO_REUSEPORT listener, so there is no single fd set to hand
+            // to a new binary: upgrades need worker_processes (or a single event loop).
+            std::cout << "Starting " << workerThreads << " worker threads." << std::endl;
+            sigset_t signals;
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGQUIT);
+            sigaddset(&signals, SIGUSR2);
+            pthread_sigmask(SIG_BLOCK, &signals, NULL); // Inherited by the workers
+            std::vector<std::unique_ptr<Server> > servers;
+            for (int i = 0; i < workerThreads; ++i) {
+                servers.push_back(std::unique_ptr<Server>(new Server(config)));
+            }
+            std::atomic<int> running(workerThreads);
+            std::vector<std::thread> workers;
+            for (int i = 0; i < workerThreads; ++i) {
+                workers.push_back(std::thread(runWorker, std::ref(*servers[i]), i, std::ref(running)));
+            }
+            superviseWorkers(servers, signals, running);
+            for (size_t i = 0; i < workers.size(); ++i) {
+                workers[i].join();
+            }
+        } else {
+            // Create and run the server
+            Upgrade::loadInheritedListeners();
+            Server::installSignalHandlers(true);
+            Server server(config);
+            server.run();
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Server error: " << e.what() << std::endl;